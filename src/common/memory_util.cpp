@@ -119,6 +119,19 @@ void FreeMemoryPages(void* ptr, size_t size) {
     }
 }
 
+void DecommitMemoryPages(void* ptr, size_t size) {
+#ifdef _WIN32
+    if (!VirtualFree(ptr, size, MEM_DECOMMIT) ||
+        VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) == nullptr)
+        LOG_ERROR(Common_Memory, "DecommitMemoryPages failed!\n%s", GetLastErrorMsg());
+#else
+    // Mapping fresh anonymous pages over the range drops the old ones
+    if (mmap(ptr, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_FIXED, -1, 0) ==
+        MAP_FAILED)
+        LOG_ERROR(Common_Memory, "DecommitMemoryPages failed!");
+#endif
+}
+
 void FreeAlignedMemory(void* ptr) {
     if (ptr) {
 #ifdef _WIN32
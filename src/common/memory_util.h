@@ -10,6 +10,9 @@
 void* AllocateExecutableMemory(size_t size, bool low = true);
 void* AllocateMemoryPages(size_t size);
 void FreeMemoryPages(void* ptr, size_t size);
+/// Gives the host memory backing pages allocated with AllocateMemoryPages back to the OS. The
+/// pages stay accessible, and read as zero afterwards.
+void DecommitMemoryPages(void* ptr, size_t size);
 void* AllocateAlignedMemory(size_t size, size_t alignment);
 void FreeAlignedMemory(void* ptr);
 void WriteProtectMemory(void* ptr, size_t size, bool executable = false);
@@ -5,157 +5,232 @@
 #pragma once
 
 #include <array>
-#include <deque>
-#include <boost/range/algorithm_ext/erase.hpp>
+#include <unordered_map>
+#include "common/assert.h"
+#include "common/bit_set.h"
+#include "common/common_types.h"
 
 namespace Common {
 
-template <class T, unsigned int N>
-struct ThreadQueueList {
-    // TODO(yuriks): If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
+/// Intrusive links of an element of a ThreadQueueList, to be embedded in the queued type.
+template <class T>
+struct ThreadQueueListNode {
+    T* prev = nullptr;
+    T* next = nullptr;
+    unsigned int priority = 0; ///< Priority level of the queue the element is in, if any
+    bool queued = false;
+};
 
+/**
+ * Per-priority FIFO queues of elements, threaded through the ThreadQueueListNode member `Node` of
+ * the elements themselves. A bitmap of the non-empty levels makes finding the highest priority
+ * element a single bit scan, so every operation is O(1) and never allocates.
+ */
+template <class T, unsigned int N, ThreadQueueListNode<T> T::*Node>
+struct ThreadQueueList {
     typedef unsigned int Priority;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
+    static_assert(NUM_QUEUES <= 64, "The priority bitmap only has 64 levels");
 
-    ThreadQueueList() {
-        first = nullptr;
+    // Only for debugging, returns priority level.
+    Priority contains(const T* thread) const {
+        const auto& node = thread->*Node;
+        return node.queued ? node.priority : -1;
     }
 
-    // Only for debugging, returns priority level.
-    Priority contains(const T& uid) {
-        for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
-                return i;
-            }
+    T* get_first() const {
+        if (non_empty == 0) {
+            return nullptr;
         }
+        return queues[LeastSignificantSetBit(non_empty)].head;
+    }
 
-        return -1;
+    T* pop_first() {
+        if (non_empty == 0) {
+            return nullptr;
+        }
+        return pop_front(LeastSignificantSetBit(non_empty));
     }
 
-    T get_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
+    /// Pops the first element of a strictly higher priority (lower level) than `priority`
+    T* pop_first_better(Priority priority) {
+        const u64 better = non_empty & ((u64(1) << priority) - 1);
+        if (better == 0) {
+            return nullptr;
         }
+        return pop_front(LeastSignificantSetBit(better));
+    }
 
-        return T();
+    void push_front(Priority priority, T* thread) {
+        auto& node = link(priority, thread);
+        Queue& cur = queues[priority];
+        node.next = cur.head;
+        if (cur.head != nullptr) {
+            (cur.head->*Node).prev = thread;
+        } else {
+            cur.tail = thread;
+        }
+        cur.head = thread;
     }
 
-    T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+    void push_back(Priority priority, T* thread) {
+        auto& node = link(priority, thread);
+        Queue& cur = queues[priority];
+        node.prev = cur.tail;
+        if (cur.tail != nullptr) {
+            (cur.tail->*Node).next = thread;
+        } else {
+            cur.head = thread;
         }
+        cur.tail = thread;
+    }
 
-        return T();
+    void move(T* thread, Priority old_priority, Priority new_priority) {
+        remove(old_priority, thread);
+        push_back(new_priority, thread);
     }
 
-    T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+    /// Removes an element from its queue. Does nothing if it isn't queued.
+    void remove(Priority priority, T* thread) {
+        auto& node = thread->*Node;
+        if (!node.queued) {
+            return;
+        }
+        DEBUG_ASSERT_MSG(node.priority == priority, "Element is queued at another priority");
+
+        Queue& cur = queues[node.priority];
+        if (node.prev != nullptr) {
+            (node.prev->*Node).next = node.next;
+        } else {
+            cur.head = node.next;
+        }
+        if (node.next != nullptr) {
+            (node.next->*Node).prev = node.prev;
+        } else {
+            cur.tail = node.prev;
         }
+        if (cur.head == nullptr) {
+            non_empty &= ~(u64(1) << node.priority);
+        }
+        node = {};
+    }
 
-        return T();
+    void rotate(Priority priority) {
+        T* first = queues[priority].head;
+        if (first != nullptr && first != queues[priority].tail) {
+            remove(priority, first);
+            push_back(priority, first);
+        }
     }
 
-    void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
+    void clear() {
+        for (Priority i = 0; i < NUM_QUEUES; ++i) {
+            while (!empty(i)) {
+                pop_front(i);
+            }
+        }
     }
 
-    void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+    bool empty(Priority priority) const {
+        return ((non_empty >> priority) & 1) == 0;
     }
 
-    void move(const T& thread_id, Priority old_priority, Priority new_priority) {
-        remove(old_priority, thread_id);
-        prepare(new_priority);
-        push_back(new_priority, thread_id);
+private:
+    struct Queue {
+        T* head = nullptr;
+        T* tail = nullptr;
+    };
+
+    ThreadQueueListNode<T>& link(Priority priority, T* thread) {
+        auto& node = thread->*Node;
+        DEBUG_ASSERT_MSG(!node.queued, "Element is already queued");
+        node.prev = nullptr;
+        node.next = nullptr;
+        node.priority = priority;
+        node.queued = true;
+        non_empty |= u64(1) << priority;
+        return node;
     }
 
-    void remove(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        boost::remove_erase(cur->data, thread_id);
+    T* pop_front(Priority priority) {
+        T* thread = queues[priority].head;
+        remove(priority, thread);
+        return thread;
     }
 
-    void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
+    // Bit i is set when the queue of priority level i is not empty.
+    u64 non_empty = 0;
+    // The priority level queues of threads.
+    std::array<Queue, NUM_QUEUES> queues;
+};
 
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
+/**
+ * ThreadQueueLists indexed by a key, such as the address their elements are waiting on, so that
+ * operations on one key never have to look at the elements queued under another one. An element
+ * may only be queued under a single key at a time. The list of a key is freed once it is empty.
+ */
+template <class Key, class T, unsigned int N, ThreadQueueListNode<T> T::*Node>
+struct KeyedThreadQueueList {
+    using List = ThreadQueueList<T, N, Node>;
+    using Priority = typename List::Priority;
+
+    T* pop_first(const Key& key) {
+        auto itr = lists.find(key);
+        if (itr == lists.end()) {
+            return nullptr;
         }
+        T* thread = itr->second.pop_first();
+        EraseIfEmpty(itr);
+        return thread;
     }
 
-    void clear() {
-        queues.fill(Queue());
-        first = nullptr;
+    void push_back(const Key& key, Priority priority, T* thread) {
+        lists[key].push_back(priority, thread);
     }
 
-    bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
+    /// Moves an element queued under `key` to another priority. Does nothing if it isn't queued.
+    void move(const Key& key, T* thread, Priority old_priority, Priority new_priority) {
+        if (!(thread->*Node).queued) {
+            return;
+        }
+        lists.at(key).move(thread, old_priority, new_priority);
     }
 
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+    /// Removes an element queued under `key`. Does nothing if it isn't queued.
+    void remove(const Key& key, Priority priority, T* thread) {
+        if (!(thread->*Node).queued) {
+            return;
+        }
+        auto itr = lists.find(key);
+        ASSERT(itr != lists.end());
+        itr->second.remove(priority, thread);
+        EraseIfEmpty(itr);
     }
 
-private:
-    struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
-    };
+    bool empty(const Key& key) const {
+        return lists.find(key) == lists.end();
+    }
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
+    void clear() {
+        for (auto& list : lists) {
+            list.second.clear();
+        }
+        lists.clear();
     }
 
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
+private:
+    using Iterator = typename std::unordered_map<Key, List>::iterator;
 
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
+    void EraseIfEmpty(Iterator itr) {
+        if (itr->second.get_first() == nullptr) {
+            lists.erase(itr);
         }
-
-        cur->next_nonempty = first;
-        first = cur;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
-    // The priority level queues of thread ids.
-    std::array<Queue, NUM_QUEUES> queues;
+    /// Lists of the keys with queued elements, none of them is ever empty
+    std::unordered_map<Key, List> lists;
 };
 
-} // namespace
+} // namespace Common
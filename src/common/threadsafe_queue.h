@@ -10,7 +10,7 @@
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
-#include <mutex>
+#include <utility>
 #include "common/common_types.h"
 
 namespace Common {
@@ -104,19 +104,81 @@ private:
     std::atomic<u32> size;
 };
 
-// a simple thread-safe,
+// a lockless thread-safe,
 // single reader, multiple writer queue
+// Producers append with a single atomic exchange on the tail, so they never block each other or
+// the reader. A push is visible to the reader once its producer has linked it into the list.
 
 template <typename T, bool NeedSize = true>
-class MPSCQueue : public SPSCQueue<T, NeedSize> {
+class MPSCQueue {
 public:
+    MPSCQueue() : size(0) {
+        read_ptr = new ElementPtr();
+        write_ptr.store(read_ptr);
+    }
+    ~MPSCQueue() {
+        DeleteAll();
+    }
+
+    u32 Size() const {
+        static_assert(NeedSize, "using Size() on FifoQueue without NeedSize");
+        return size.load();
+    }
+
+    bool Empty() const {
+        return !read_ptr->next.load(std::memory_order_acquire);
+    }
+
     template <typename Arg>
     void Push(Arg&& t) {
-        std::lock_guard<std::mutex> lock(write_lock);
-        SPSCQueue<T, NeedSize>::Push(t);
+        ElementPtr* new_ptr = new ElementPtr();
+        new_ptr->current = std::forward<Arg>(t);
+        // claim the tail, then link the previous tail to the new element
+        ElementPtr* prev_ptr = write_ptr.exchange(new_ptr, std::memory_order_acq_rel);
+        prev_ptr->next.store(new_ptr, std::memory_order_release);
+        if (NeedSize)
+            size++;
+    }
+
+    bool Pop(T& t) {
+        ElementPtr* next_ptr = read_ptr->next.load(std::memory_order_acquire);
+        if (!next_ptr)
+            return false;
+
+        if (NeedSize)
+            size--;
+
+        // the element after the read pointer holds the value, and becomes the new dummy head
+        t = std::move(next_ptr->current);
+        delete read_ptr;
+        read_ptr = next_ptr;
+        return true;
+    }
+
+    // not thread-safe
+    void Clear() {
+        size.store(0);
+        DeleteAll();
+        read_ptr = new ElementPtr();
+        write_ptr.store(read_ptr);
     }
 
 private:
-    std::mutex write_lock;
+    struct ElementPtr {
+        T current{};
+        std::atomic<ElementPtr*> next{nullptr};
+    };
+
+    void DeleteAll() {
+        while (read_ptr) {
+            ElementPtr* next_ptr = read_ptr->next.load();
+            delete read_ptr;
+            read_ptr = next_ptr;
+        }
+    }
+
+    ElementPtr* read_ptr;
+    std::atomic<ElementPtr*> write_ptr;
+    std::atomic<u32> size;
 };
 } // namespace Common
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "core/hle/kernel/vm_manager.h"
 
@@ -128,6 +129,14 @@ public:
         return num_instructions;
     }
 
+    /**
+     * Returns how many ticks the Run call in progress, or the last one once it returned, has
+     * executed so far. None if the backend can't tell before the call returns.
+     */
+    virtual boost::optional<u64> GetTicksExecutedInRun() const {
+        return boost::none;
+    }
+
 protected:
     /**
      * Executes the given number of instructions
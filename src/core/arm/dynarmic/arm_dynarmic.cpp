@@ -7,7 +7,7 @@
 #include <dynarmic/A64/a64.h>
 #include <dynarmic/A64/config.h>
 #include "core/arm/dynarmic/arm_dynarmic.h"
-#include "core/core_timing.h"
+#include "core/core.h"
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
 
@@ -43,13 +43,36 @@ public:
     }
 
     void InterpreterFallback(u64 pc, size_t num_instructions) override {
+        Core::System::GetInstance().perf_stats.AddInterpreterFallback(Memory::Read32(pc),
+                                                                      num_instructions);
+
+        // Only transfer the vector register file when one of the interpreted instructions may
+        // actually access it, as that makes up the bulk of the cost of switching into Unicorn.
+        bool uses_vectors = false;
+        for (size_t i = 0; i < num_instructions && !uses_vectors; ++i) {
+            uses_vectors = AccessesVectorRegisters(Memory::Read32(pc + i * 4));
+        }
+
         ARM_Interface::ThreadContext ctx;
         parent.SaveContext(ctx);
-        parent.inner_unicorn.LoadContext(ctx);
+        parent.inner_unicorn.LoadContext(ctx, uses_vectors);
         parent.inner_unicorn.ExecuteInstructions(num_instructions);
-        parent.inner_unicorn.SaveContext(ctx);
+        parent.inner_unicorn.SaveContext(ctx, uses_vectors);
         parent.LoadContext(ctx);
-        num_interpreted_instructions += num_instructions;
+    }
+
+    /// Returns whether the given A64 instruction may read or write the SIMD&FP registers
+    static bool AccessesVectorRegisters(u32 instruction) {
+        // Data processing - SIMD and floating point (op0 == x111)
+        if ((instruction & 0x0E000000) == 0x0E000000) {
+            return true;
+        }
+        // Loads and stores (op0 == x1x0) with the V bit set
+        if ((instruction & 0x0A000000) == 0x08000000) {
+            return (instruction & 0x04000000) != 0;
+        }
+        // System register accesses may target FPCR/FPSR
+        return (instruction & 0xFFC00000) == 0xD5000000;
     }
 
     void ExceptionRaised(u64 pc, Dynarmic::A64::Exception /*exception*/) override {
@@ -66,21 +89,37 @@ public:
             ticks_remaining = 0;
             return;
         }
-        ticks -= ticks_remaining;
+        ticks_remaining -= ticks;
     }
     u64 GetTicksRemaining() override {
         return ticks_remaining;
     }
 
     ARM_Dynarmic& parent;
+    size_t ticks_in_run = 0;
     size_t ticks_remaining = 0;
-    size_t num_interpreted_instructions = 0;
     u64 tpidrr0_el0 = 0;
 };
 
+static std::unique_ptr<Dynarmic::A64::Jit> MakeJit(const std::unique_ptr<ARM_Dynarmic_Callbacks>& cb,
+                                                   Memory::PageTable* page_table) {
+    Dynarmic::A64::UserConfig config;
+    config.callbacks = cb.get();
+
+    // Let the generated code perform the page table lookup inline, it only has to call back into
+    // the memory callbacks for pages that are not backed by regular memory. This is as close to
+    // fastmem as this version of Dynarmic goes: it can't emit plain host loads into a reserved
+    // copy of the guest address space and recover from faults on them.
+    if (page_table) {
+        config.page_table = reinterpret_cast<void**>(page_table->pointers);
+    }
+
+    return std::make_unique<Dynarmic::A64::Jit>(config);
+}
+
 ARM_Dynarmic::ARM_Dynarmic()
     : cb(std::make_unique<ARM_Dynarmic_Callbacks>(*this)),
-      jit(Dynarmic::A64::UserConfig{cb.get()}) {
+      current_page_table(Memory::GetCurrentPageTable()), jit(MakeJit(cb, current_page_table)) {
     ARM_Interface::ThreadContext ctx;
     inner_unicorn.SaveContext(ctx);
     LoadContext(ctx);
@@ -90,31 +129,33 @@ ARM_Dynarmic::~ARM_Dynarmic() = default;
 
 void ARM_Dynarmic::MapBackingMemory(u64 address, size_t size, u8* memory,
                                     Kernel::VMAPermission perms) {
+    // The inner Unicorn instance only applies the mapping when it runs the next interpreter
+    // fallback, on this core's thread
     inner_unicorn.MapBackingMemory(address, size, memory, perms);
 }
 
 void ARM_Dynarmic::SetPC(u64 pc) {
-    jit.SetPC(pc);
+    jit->SetPC(pc);
 }
 
 u64 ARM_Dynarmic::GetPC() const {
-    return jit.GetPC();
+    return jit->GetPC();
 }
 
 u64 ARM_Dynarmic::GetReg(int index) const {
-    return jit.GetRegister(index);
+    return jit->GetRegister(index);
 }
 
 void ARM_Dynarmic::SetReg(int index, u64 value) {
-    jit.SetRegister(index, value);
+    jit->SetRegister(index, value);
 }
 
 u128 ARM_Dynarmic::GetExtReg(int index) const {
-    return jit.GetVector(index);
+    return jit->GetVector(index);
 }
 
 void ARM_Dynarmic::SetExtReg(int index, u128 value) {
-    jit.SetVector(index, value);
+    jit->SetVector(index, value);
 }
 
 u32 ARM_Dynarmic::GetVFPReg(int /*index*/) const {
@@ -127,11 +168,11 @@ void ARM_Dynarmic::SetVFPReg(int /*index*/, u32 /*value*/) {
 }
 
 u32 ARM_Dynarmic::GetCPSR() const {
-    return jit.GetPstate();
+    return jit->GetPstate();
 }
 
 void ARM_Dynarmic::SetCPSR(u32 cpsr) {
-    jit.SetPstate(cpsr);
+    jit->SetPstate(cpsr);
 }
 
 u64 ARM_Dynarmic::GetTlsAddress() const {
@@ -143,42 +184,64 @@ void ARM_Dynarmic::SetTlsAddress(u64 address) {
 }
 
 void ARM_Dynarmic::ExecuteInstructions(int num_instructions) {
+    if (page_table_changed.exchange(false)) {
+        RebuildJit();
+    }
+    ASSERT(Memory::GetCurrentPageTable() == current_page_table);
+
+    cb->ticks_in_run = num_instructions;
     cb->ticks_remaining = num_instructions;
-    jit.Run();
-    CoreTiming::AddTicks(num_instructions - cb->num_interpreted_instructions);
-    cb->num_interpreted_instructions = 0;
+    jit->Run();
+}
+
+boost::optional<u64> ARM_Dynarmic::GetTicksExecutedInRun() const {
+    return cb->ticks_in_run - cb->ticks_remaining;
 }
 
 void ARM_Dynarmic::SaveContext(ARM_Interface::ThreadContext& ctx) {
-    ctx.cpu_registers = jit.GetRegisters();
-    ctx.sp = jit.GetSP();
-    ctx.pc = jit.GetPC();
-    ctx.cpsr = jit.GetPstate();
-    ctx.fpu_registers = jit.GetVectors();
-    ctx.fpscr = jit.GetFpcr();
+    ctx.cpu_registers = jit->GetRegisters();
+    ctx.sp = jit->GetSP();
+    ctx.pc = jit->GetPC();
+    ctx.cpsr = jit->GetPstate();
+    ctx.fpu_registers = jit->GetVectors();
+    ctx.fpscr = jit->GetFpcr();
     ctx.tls_address = cb->tpidrr0_el0;
 }
 
 void ARM_Dynarmic::LoadContext(const ARM_Interface::ThreadContext& ctx) {
-    jit.SetRegisters(ctx.cpu_registers);
-    jit.SetSP(ctx.sp);
-    jit.SetPC(ctx.pc);
-    jit.SetPstate(ctx.cpsr);
-    jit.SetVectors(ctx.fpu_registers);
-    jit.SetFpcr(ctx.fpscr);
+    jit->SetRegisters(ctx.cpu_registers);
+    jit->SetSP(ctx.sp);
+    jit->SetPC(ctx.pc);
+    jit->SetPstate(ctx.cpsr);
+    jit->SetVectors(ctx.fpu_registers);
+    jit->SetFpcr(ctx.fpscr);
     cb->tpidrr0_el0 = ctx.tls_address;
 }
 
 void ARM_Dynarmic::PrepareReschedule() {
-    if (jit.IsExecuting()) {
-        jit.HaltExecution();
+    if (jit->IsExecuting()) {
+        jit->HaltExecution();
     }
 }
 
 void ARM_Dynarmic::ClearInstructionCache() {
-    jit.ClearCache();
+    jit->ClearCache();
 }
 
 void ARM_Dynarmic::PageTableChanged() {
-    UNIMPLEMENTED();
+    // This may be called from another core's thread while this one is running its JIT, so the
+    // JIT is only rebuilt by this core itself before it runs again
+    page_table_changed = true;
+}
+
+void ARM_Dynarmic::RebuildJit() {
+    // The page table is baked into the JIT configuration, so a new JIT instance has to be built
+    // for the new address space
+    ARM_Interface::ThreadContext ctx;
+    SaveContext(ctx);
+
+    current_page_table = Memory::GetCurrentPageTable();
+    jit = MakeJit(cb, current_page_table);
+
+    LoadContext(ctx);
 }
@@ -4,12 +4,17 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <dynarmic/A64/a64.h>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/unicorn/arm_unicorn.h"
 
+namespace Memory {
+struct PageTable;
+}
+
 class ARM_Dynarmic_Callbacks;
 
 class ARM_Dynarmic final : public ARM_Interface {
@@ -38,13 +43,21 @@ public:
 
     void PrepareReschedule() override;
     void ExecuteInstructions(int num_instructions) override;
+    boost::optional<u64> GetTicksExecutedInRun() const override;
 
     void ClearInstructionCache() override;
     void PageTableChanged() override;
 
 private:
+    /// Builds a JIT instance for the current page table, carrying the guest state over to it
+    void RebuildJit();
+
     friend class ARM_Dynarmic_Callbacks;
     std::unique_ptr<ARM_Dynarmic_Callbacks> cb;
-    Dynarmic::A64::Jit jit;
+    /// Page table the current JIT instance was configured with
+    Memory::PageTable* current_page_table = nullptr;
+    /// Set from any host thread when the JIT has to be rebuilt before it runs again
+    std::atomic<bool> page_table_changed{false};
+    std::unique_ptr<Dynarmic::A64::Jit> jit;
     ARM_Unicorn inner_unicorn;
 };
@@ -7,7 +7,6 @@
 #include "common/microprofile.h"
 #include "core/arm/unicorn/arm_unicorn.h"
 #include "core/core.h"
-#include "core/core_timing.h"
 #include "core/hle/kernel/svc.h"
 
 // Load Unicorn DLL once on Windows using RAII
@@ -44,6 +43,8 @@ static void InterruptHook(uc_engine* uc, u32 intNo, void* user_data) {
     switch (ec) {
     case 0x15: // SVC
         Kernel::CallSVC(iss);
+        // The SVC may have mapped memory which the rest of the slice is going to access
+        static_cast<ARM_Unicorn*>(user_data)->ApplyPendingMappings();
         break;
     }
 }
@@ -73,7 +74,43 @@ ARM_Unicorn::~ARM_Unicorn() {
 
 void ARM_Unicorn::MapBackingMemory(VAddr address, size_t size, u8* memory,
                                    Kernel::VMAPermission perms) {
-    CHECKED(uc_mem_map_ptr(uc, address, size, static_cast<u32>(perms), memory));
+    const VAddr end = address + size;
+
+    std::lock_guard<std::mutex> lock(pending_mappings_mutex);
+
+    // Keep only the parts of the older mappings that the new one doesn't cover
+    std::vector<BackingMemory> mappings;
+    mappings.reserve(pending_mappings.size() + 2);
+    for (const auto& mapping : pending_mappings) {
+        const VAddr mapping_end = mapping.address + mapping.size;
+        if (mapping_end <= address || mapping.address >= end) {
+            mappings.push_back(mapping);
+            continue;
+        }
+        if (mapping.address < address) {
+            mappings.push_back(
+                {mapping.address, address - mapping.address, mapping.memory, mapping.perms});
+        }
+        if (mapping_end > end) {
+            mappings.push_back({end, mapping_end - end, mapping.memory + (end - mapping.address),
+                                mapping.perms});
+        }
+    }
+    mappings.push_back({address, size, memory, perms});
+    pending_mappings = std::move(mappings);
+}
+
+void ARM_Unicorn::ApplyPendingMappings() {
+    std::vector<BackingMemory> mappings;
+    {
+        std::lock_guard<std::mutex> lock(pending_mappings_mutex);
+        mappings.swap(pending_mappings);
+    }
+
+    for (const auto& mapping : mappings) {
+        CHECKED(uc_mem_map_ptr(uc, mapping.address, mapping.size,
+                               static_cast<u32>(mapping.perms), mapping.memory));
+    }
 }
 
 void ARM_Unicorn::SetPC(u64 pc) {
@@ -152,11 +189,15 @@ MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
 
 void ARM_Unicorn::ExecuteInstructions(int num_instructions) {
     MICROPROFILE_SCOPE(ARM_Jit);
+    ApplyPendingMappings();
     CHECKED(uc_emu_start(uc, GetPC(), 1ULL << 63, 0, num_instructions));
-    CoreTiming::AddTicks(num_instructions);
 }
 
 void ARM_Unicorn::SaveContext(ARM_Interface::ThreadContext& ctx) {
+    SaveContext(ctx, true);
+}
+
+void ARM_Unicorn::SaveContext(ARM_Interface::ThreadContext& ctx, bool include_vectors) {
     int uregs[32];
     void* tregs[32];
 
@@ -177,6 +218,10 @@ void ARM_Unicorn::SaveContext(ARM_Interface::ThreadContext& ctx) {
 
     ctx.tls_address = GetTlsAddress();
 
+    if (!include_vectors) {
+        return;
+    }
+
     for (int i = 0; i < 32; ++i) {
         uregs[i] = UC_ARM64_REG_Q0 + i;
         tregs[i] = &ctx.fpu_registers[i];
@@ -186,6 +231,10 @@ void ARM_Unicorn::SaveContext(ARM_Interface::ThreadContext& ctx) {
 }
 
 void ARM_Unicorn::LoadContext(const ARM_Interface::ThreadContext& ctx) {
+    LoadContext(ctx, true);
+}
+
+void ARM_Unicorn::LoadContext(const ARM_Interface::ThreadContext& ctx, bool include_vectors) {
     int uregs[32];
     void* tregs[32];
 
@@ -206,6 +255,10 @@ void ARM_Unicorn::LoadContext(const ARM_Interface::ThreadContext& ctx) {
 
     SetTlsAddress(ctx.tls_address);
 
+    if (!include_vectors) {
+        return;
+    }
+
     for (auto i = 0; i < 32; ++i) {
         uregs[i] = UC_ARM64_REG_Q0 + i;
         tregs[i] = (void*)&ctx.fpu_registers[i];
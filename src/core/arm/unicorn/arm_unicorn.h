@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <mutex>
+#include <vector>
 #include <unicorn/unicorn.h>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
@@ -12,8 +14,17 @@ class ARM_Unicorn final : public ARM_Interface {
 public:
     ARM_Unicorn();
     ~ARM_Unicorn();
+
+    /**
+     * Queues a mapping of host memory into the Unicorn instance. This may be called from any host
+     * thread, the mapping is only applied by the thread running this instance.
+     */
     void MapBackingMemory(VAddr address, size_t size, u8* memory,
                           Kernel::VMAPermission perms) override;
+
+    /// Applies the queued mappings, must be called from the thread running this instance
+    void ApplyPendingMappings();
+
     void SetPC(u64 pc) override;
     u64 GetPC() const override;
     u64 GetReg(int index) const override;
@@ -28,11 +39,32 @@ public:
     void SetTlsAddress(VAddr address) override;
     void SaveContext(ThreadContext& ctx) override;
     void LoadContext(const ThreadContext& ctx) override;
+
+    /**
+     * Saves/loads the given context, optionally skipping the SIMD&FP register file. Transferring
+     * the vector registers is the most expensive part of a context switch into Unicorn, and can
+     * be omitted when the instructions about to be executed are known not to touch them.
+     */
+    void SaveContext(ThreadContext& ctx, bool include_vectors);
+    void LoadContext(const ThreadContext& ctx, bool include_vectors);
+
     void PrepareReschedule() override;
     void ExecuteInstructions(int num_instructions) override;
     void ClearInstructionCache() override;
     void PageTableChanged() override{};
 
 private:
+    /// Memory mapping that has not been applied to the Unicorn instance yet
+    struct BackingMemory {
+        VAddr address;
+        size_t size;
+        u8* memory;
+        Kernel::VMAPermission perms;
+    };
+
     uc_engine* uc{};
+
+    /// Queued mappings, in order and without overlaps: a newer mapping trims the older ones
+    std::vector<BackingMemory> pending_mappings;
+    std::mutex pending_mappings_mutex;
 };
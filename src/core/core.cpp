@@ -2,16 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <cinttypes>
 #include <memory>
 #include <utility>
+#include "common/assert.h"
 #include "common/logging/log.h"
-#include "core/arm/dynarmic/arm_dynarmic.h"
-#include "core/arm/unicorn/arm_unicorn.h"
+#include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/kernel/scheduler.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/service/service.h"
 #include "core/hw/hw.h"
@@ -24,9 +27,16 @@ namespace Core {
 
 /*static*/ System System::s_instance;
 
+/// Runs a CPU core on its own host thread while the system is powered on
+static void RunCpuCore(std::shared_ptr<Cpu> cpu_state) {
+    while (System::GetInstance().IsPoweredOn()) {
+        cpu_state->RunLoop();
+    }
+}
+
 System::ResultStatus System::RunLoop(int tight_loop) {
     status = ResultStatus::Success;
-    if (!cpu_core) {
+    if (!cpu_cores[0]) {
         return ResultStatus::ErrorNotInitialized;
     }
 
@@ -45,20 +55,17 @@ System::ResultStatus System::RunLoop(int tight_loop) {
         }
     }
 
-    // If we don't have a currently active thread then don't execute instructions,
-    // instead advance to the next event and try to yield to the next thread
-    if (Kernel::GetCurrentThread() == nullptr) {
-        LOG_TRACE(Core_ARM, "Idling");
-        CoreTiming::Idle();
-        CoreTiming::Advance();
-        PrepareReschedule();
+    if (multi_core) {
+        // Cores 1-3 run on their own host threads, in lock-step with this one
+        cpu_cores[0]->RunLoop(tight_loop);
     } else {
-        CoreTiming::Advance();
-        cpu_core->Run(tight_loop);
+        for (active_core = 0; active_core < NUM_CPU_CORES; ++active_core) {
+            cpu_cores[active_core]->RunLoop(tight_loop);
+        }
+        active_core = 0;
     }
 
     HW::Update();
-    Reschedule();
 
     return status;
 }
@@ -68,6 +75,8 @@ System::ResultStatus System::SingleStep() {
 }
 
 System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& filepath) {
+    perf_stats.BeginStartup();
+
     app_loader = Loader::GetLoader(filepath);
 
     if (!app_loader) {
@@ -99,6 +108,8 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
         return init_result;
     }
 
+    launch_metrics.Open();
+
     const Loader::ResultStatus load_result{app_loader->Load(Kernel::g_current_process)};
     if (Loader::ResultStatus::Success != load_result) {
         LOG_CRITICAL(Core, "Failed to load ROM (Error %i)!", load_result);
@@ -118,34 +129,55 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
 }
 
 void System::PrepareReschedule() {
-    cpu_core->PrepareReschedule();
-    reschedule_pending = true;
+    CurrentCpuCore().PrepareReschedule();
 }
 
 PerfStats::Results System::GetAndResetPerfStats() {
     return perf_stats.GetAndResetStats(CoreTiming::GetGlobalTimeUs());
 }
 
-void System::Reschedule() {
-    if (!reschedule_pending) {
-        return;
+ARM_Interface& System::CurrentArmInterface() {
+    return CurrentCpuCore().ArmInterface();
+}
+
+ARM_Interface& System::ArmInterface(size_t core_index) {
+    return CpuCore(core_index).ArmInterface();
+}
+
+Cpu& System::CurrentCpuCore() {
+    if (!multi_core) {
+        return *cpu_cores[active_core];
+    }
+
+    // Host threads that don't run a core (e.g. the frontend's debugging widgets) see core 0
+    const auto search = thread_to_cpu.find(std::this_thread::get_id());
+    if (search == thread_to_cpu.end()) {
+        return *cpu_cores[0];
     }
+    return *search->second;
+}
+
+Cpu& System::CpuCore(size_t core_index) {
+    ASSERT(core_index < NUM_CPU_CORES);
+    return *cpu_cores[core_index];
+}
 
-    reschedule_pending = false;
-    Kernel::Reschedule();
+Kernel::Scheduler& System::CurrentScheduler() {
+    return *CurrentCpuCore().Scheduler();
+}
+
+const std::shared_ptr<Kernel::Scheduler>& System::Scheduler(size_t core_index) {
+    return CpuCore(core_index).Scheduler();
 }
 
 System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
     LOG_DEBUG(HW_Memory, "initialized OK");
 
-    switch (Settings::values.cpu_core) {
-    case Settings::CpuCore::Unicorn:
-        cpu_core = std::make_unique<ARM_Unicorn>();
-        break;
-    case Settings::CpuCore::Dynarmic:
-    default:
-        cpu_core = std::make_unique<ARM_Dynarmic>();
-        break;
+    multi_core = Settings::values.use_multi_core;
+    active_core = 0;
+    cpu_barrier = std::make_shared<CpuBarrier>(multi_core ? NUM_CPU_CORES : 1);
+    for (size_t index = 0; index < cpu_cores.size(); ++index) {
+        cpu_cores[index] = std::make_shared<Cpu>(cpu_barrier, index);
     }
 
     telemetry_session = std::make_unique<Core::TelemetrySession>();
@@ -160,6 +192,16 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
         return ResultStatus::ErrorVideoCore;
     }
 
+    // Core 0 is run on the emulation thread, create threads for cores 1-3. They wait at the
+    // barrier until the emulation thread starts running core 0.
+    thread_to_cpu[std::this_thread::get_id()] = cpu_cores[0];
+    if (multi_core) {
+        for (size_t index = 0; index < cpu_core_threads.size(); ++index) {
+            cpu_core_threads[index] = std::make_unique<std::thread>(RunCpuCore, cpu_cores[index + 1]);
+            thread_to_cpu[cpu_core_threads[index]->get_id()] = cpu_cores[index + 1];
+        }
+    }
+
     LOG_DEBUG(Core, "Initialized OK");
 
     // Reset counters and set time origin to current frame
@@ -179,6 +221,35 @@ void System::Shutdown() {
     Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                          perf_results.frametime * 1000.0);
 
+    const auto startup_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(perf_stats.GetStartupTime());
+    if (startup_time.count() != 0) {
+        LOG_INFO(Core, "Time to first frame: %lld us", static_cast<long long>(startup_time.count()));
+        Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_StartupTime",
+                             startup_time);
+        launch_metrics.SetStartupTime(static_cast<u64>(startup_time.count()));
+    }
+    launch_metrics.Close();
+
+    // Report the instructions that most often had to be interpreted, as they are the best
+    // candidates for implementing in the JIT
+    for (const auto& fallback : perf_stats.GetTopInterpreterFallbacks(10)) {
+        LOG_INFO(Core, "Interpreter fallback: instruction=%08X, count=%" PRIu64, fallback.first,
+                 fallback.second);
+    }
+
+    // Stop the CPU core threads before tearing down the state they use
+    if (cpu_barrier) {
+        cpu_barrier->NotifyEnd();
+    }
+    for (auto& thread : cpu_core_threads) {
+        if (thread) {
+            thread->join();
+            thread.reset();
+        }
+    }
+    thread_to_cpu.clear();
+
     // Shutdown emulation session
     GDBStub::Shutdown();
     VideoCore::Shutdown();
@@ -186,7 +257,10 @@ void System::Shutdown() {
     Kernel::Shutdown();
     HW::Shutdown();
     CoreTiming::Shutdown();
-    cpu_core = nullptr;
+    for (auto& cpu_core : cpu_cores) {
+        cpu_core.reset();
+    }
+    cpu_barrier.reset();
     app_loader = nullptr;
     telemetry_session = nullptr;
 
@@ -4,9 +4,14 @@
 
 #pragma once
 
+#include <array>
+#include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include "common/common_types.h"
+#include "core/core_cpu.h"
+#include "core/launch_metrics.h"
 #include "core/loader/loader.h"
 #include "core/memory.h"
 #include "core/perf_stats.h"
@@ -15,6 +20,10 @@
 class EmuWindow;
 class ARM_Interface;
 
+namespace Kernel {
+class Scheduler;
+}
+
 namespace Core {
 
 class System {
@@ -78,7 +87,7 @@ public:
      * @returns True if the emulated system is powered on, otherwise false.
      */
     bool IsPoweredOn() const {
-        return cpu_core != nullptr;
+        return cpu_barrier && cpu_barrier->IsAlive();
     }
 
     /**
@@ -95,15 +104,34 @@ public:
     PerfStats::Results GetAndResetPerfStats();
 
     /**
-     * Gets a reference to the emulated CPU.
+     * Gets a reference to the emulated CPU running on the calling host thread.
      * @returns A reference to the emulated CPU.
      */
     ARM_Interface& CPU() {
-        return *cpu_core;
+        return CurrentArmInterface();
     }
 
+    /// Gets a reference to the ARM backend of the CPU core running on the calling host thread
+    ARM_Interface& CurrentArmInterface();
+
+    /// Gets a reference to the ARM backend of the specified CPU core
+    ARM_Interface& ArmInterface(size_t core_index);
+
+    /// Gets a reference to the CPU core running on the calling host thread
+    Cpu& CurrentCpuCore();
+
+    /// Gets a reference to the specified CPU core
+    Cpu& CpuCore(size_t core_index);
+
+    /// Gets the scheduler of the CPU core running on the calling host thread
+    Kernel::Scheduler& CurrentScheduler();
+
+    /// Gets the scheduler of the specified CPU core
+    const std::shared_ptr<Kernel::Scheduler>& Scheduler(size_t core_index);
+
     PerfStats perf_stats;
     FrameLimiter frame_limiter;
+    LaunchMetrics launch_metrics;
 
     void SetStatus(ResultStatus new_status, const char* details = nullptr) {
         status = new_status;
@@ -129,17 +157,22 @@ private:
      */
     ResultStatus Init(EmuWindow* emu_window, u32 system_mode);
 
-    /// Reschedule the core emulation
-    void Reschedule();
-
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
-    ///< ARM11 CPU core
-    std::unique_ptr<ARM_Interface> cpu_core;
+    /// Emulated CPU cores, core 0 is always run on the emulation thread
+    std::array<std::shared_ptr<Cpu>, NUM_CPU_CORES> cpu_cores;
+    std::array<std::unique_ptr<std::thread>, NUM_CPU_CORES - 1> cpu_core_threads;
+    std::shared_ptr<CpuBarrier> cpu_barrier;
+
+    /// Whether cores 1-3 have host threads of their own, fixed for the emulation session
+    bool multi_core{};
+
+    /// In single-core mode, the index of the core currently being run by the emulation thread
+    size_t active_core{};
 
-    /// When true, signals that a reschedule should happen
-    bool reschedule_pending{};
+    /// Map of host threads to the CPU cores they run, only used in multi-core mode
+    std::map<std::thread::id, std::shared_ptr<Cpu>> thread_to_cpu;
 
     /// Telemetry session for this emulation session
     std::unique_ptr<Core::TelemetrySession> telemetry_session;
@@ -0,0 +1,148 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <mutex>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/arm/arm_interface.h"
+#include "core/arm/dynarmic/arm_dynarmic.h"
+#include "core/arm/unicorn/arm_unicorn.h"
+#include "core/core.h"
+#include "core/core_cpu.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/scheduler.h"
+#include "core/hle/lock.h"
+#include "core/settings.h"
+
+namespace Core {
+
+void CpuBarrier::NotifyEnd() {
+    std::unique_lock<std::mutex> lock(mutex);
+    end = true;
+    condition.notify_all();
+}
+
+bool CpuBarrier::Rendezvous() {
+    if (num_cores == 1) {
+        // Nothing to synchronize with when all the cores are run from a single host thread
+        return IsAlive();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (end) {
+        return false;
+    }
+
+    const u64 current_generation = generation;
+    if (++cores_waiting == num_cores) {
+        cores_waiting = 0;
+        ++generation;
+        condition.notify_all();
+        return true;
+    }
+
+    condition.wait(lock, [&] { return end || generation != current_generation; });
+    return generation != current_generation;
+}
+
+Cpu::Cpu(std::shared_ptr<CpuBarrier> cpu_barrier, size_t core_index)
+    : cpu_barrier{std::move(cpu_barrier)}, core_index{core_index} {
+
+    switch (Settings::values.cpu_core) {
+    case Settings::CpuCore::Unicorn:
+        arm_interface = std::make_unique<ARM_Unicorn>();
+        break;
+    case Settings::CpuCore::Dynarmic:
+    default:
+        arm_interface = std::make_unique<ARM_Dynarmic>();
+        break;
+    }
+
+    scheduler = std::make_shared<Kernel::Scheduler>(arm_interface.get());
+}
+
+Cpu::~Cpu() = default;
+
+void Cpu::RunLoop(int tight_loop) {
+    // Wait for all other CPU cores to complete the previous slice, such that they run in lock-step
+    if (!cpu_barrier->Rendezvous()) {
+        // The emulation session has been ended
+        return;
+    }
+
+    // If we don't have a currently active thread then don't execute instructions,
+    // instead advance to the next event and try to yield to the next thread
+    if (scheduler->GetCurrentThread() == nullptr) {
+        LOG_TRACE(Core, "Core-%zu idling", core_index);
+
+        if (IsMainCore()) {
+            std::lock_guard<HLE::ProfiledMutex> lock(HLE::g_hle_lock);
+            CoreTiming::Idle();
+            CoreTiming::Advance();
+        }
+
+        PrepareReschedule();
+    } else {
+        if (IsMainCore()) {
+            std::lock_guard<HLE::ProfiledMutex> lock(HLE::g_hle_lock);
+            CoreTiming::Advance();
+        }
+
+        const auto run_begin = PerfStats::Clock::now();
+        arm_interface->Run(tight_loop);
+        System::GetInstance().perf_stats.AddSubsystemTime(PerfStats::Subsystem::Cpu,
+                                                          PerfStats::Clock::now() - run_begin);
+
+        if (IsMainCore()) {
+            std::lock_guard<HLE::ProfiledMutex> lock(HLE::g_hle_lock);
+            // A skip already ended the slice, only the ticks which actually ran are left to add
+            CoreTiming::AddTicks(skipped_to_next_event ? *arm_interface->GetTicksExecutedInRun()
+                                                       : tight_loop);
+            skipped_to_next_event = false;
+        }
+    }
+
+    Reschedule();
+}
+
+void Cpu::SingleStep() {
+    return RunLoop(1);
+}
+
+void Cpu::PrepareReschedule() {
+    arm_interface->PrepareReschedule();
+    reschedule_pending = true;
+}
+
+u64 Cpu::SkipToNextEvent() {
+    ASSERT(IsMainCore());
+
+    // The ticks executed by the run in progress are only added to CoreTiming once it returns, so
+    // they are still part of the downcount
+    const auto ticks_executed = arm_interface->GetTicksExecutedInRun();
+    if (!ticks_executed) {
+        return 0;
+    }
+    const s64 skipped_cycles = CoreTiming::GetDowncount() - static_cast<s64>(*ticks_executed);
+    if (skipped_cycles <= 0) {
+        return 0;
+    }
+
+    CoreTiming::Idle(static_cast<int>(skipped_cycles));
+    skipped_to_next_event = true;
+    PrepareReschedule();
+    return static_cast<u64>(skipped_cycles);
+}
+
+void Cpu::Reschedule() {
+    if (!reschedule_pending) {
+        return;
+    }
+
+    reschedule_pending = false;
+    std::lock_guard<HLE::ProfiledMutex> lock(HLE::g_hle_lock);
+    scheduler->Reschedule();
+}
+
+} // namespace Core
@@ -0,0 +1,116 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include "common/common_types.h"
+
+class ARM_Interface;
+
+namespace Kernel {
+class Scheduler;
+}
+
+namespace Core {
+
+constexpr unsigned NUM_CPU_CORES{4};
+
+/**
+ * Keeps the emulated CPU cores in lock-step when they are run on separate host threads: every core
+ * must finish its current time slice before any of them may start the next one.
+ */
+class CpuBarrier {
+public:
+    explicit CpuBarrier(unsigned num_cores) : num_cores(num_cores) {}
+
+    /// Returns whether the emulation session is still running
+    bool IsAlive() const {
+        return !end;
+    }
+
+    /// Ends the emulation session, releasing any core waiting at the barrier
+    void NotifyEnd();
+
+    /**
+     * Waits until every core has reached the barrier
+     * @return False if the emulation session was ended while waiting, true otherwise
+     */
+    bool Rendezvous();
+
+private:
+    const unsigned num_cores;
+    unsigned cores_waiting{};
+    u64 generation{};
+    std::atomic<bool> end{};
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+/// Emulated CPU core, pairing an ARM backend with the scheduler of the guest threads it runs
+class Cpu {
+public:
+    Cpu(std::shared_ptr<CpuBarrier> cpu_barrier, size_t core_index);
+    ~Cpu();
+
+    /**
+     * Runs the core for a time slice of the specified number of instructions
+     * @param tight_loop Number of instructions to execute.
+     */
+    void RunLoop(int tight_loop = 100000);
+
+    /// Steps the core a single instruction
+    void SingleStep();
+
+    /// Prepares the core for a reschedule at the end of the current time slice
+    void PrepareReschedule();
+
+    /**
+     * Skips the time left until the next CoreTiming event, as the running guest thread is only
+     * waiting for it. Must be called from the main core's own thread, with the HLE lock held.
+     * @return The number of cycles skipped
+     */
+    u64 SkipToNextEvent();
+
+    ARM_Interface& ArmInterface() {
+        return *arm_interface;
+    }
+
+    const ARM_Interface& ArmInterface() const {
+        return *arm_interface;
+    }
+
+    const std::shared_ptr<Kernel::Scheduler>& Scheduler() const {
+        return scheduler;
+    }
+
+    /// The main core drives CoreTiming, the other cores follow its timeline
+    bool IsMainCore() const {
+        return core_index == 0;
+    }
+
+    size_t CoreIndex() const {
+        return core_index;
+    }
+
+private:
+    /// Switches to the next ready thread if a reschedule was requested
+    void Reschedule();
+
+    std::unique_ptr<ARM_Interface> arm_interface;
+    std::shared_ptr<CpuBarrier> cpu_barrier;
+    std::shared_ptr<Kernel::Scheduler> scheduler;
+
+    /// When true, signals that a reschedule should happen. Set from any core.
+    std::atomic<bool> reschedule_pending{};
+    /// Whether the time slice being run was cut short by SkipToNextEvent
+    bool skipped_to_next_event = false;
+    size_t core_index;
+};
+
+} // namespace Core
@@ -32,6 +32,14 @@ struct Event {
     u64 fifo_order;
     u64 userdata;
     const EventType* type;
+    u32 slot; ///< Index of the slot tracking the position of this event in the queue
+};
+
+/// Tracks the position of a scheduled event in the queue, so that it can be removed directly
+struct EventSlot {
+    u32 generation;  ///< Incremented whenever the slot is freed, invalidating old handles
+    u32 queue_index; ///< Index of the event in event_queue, only valid while the slot is in use
+    bool in_use;
 };
 
 // Sort by time, unless the times are the same, in which case sort by the order added to the queue
@@ -47,13 +55,15 @@ static bool operator<(const Event& left, const Event& right) {
 // remain stable regardless of rehashes/resizing.
 static std::unordered_map<std::string, EventType> event_types;
 
-// The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-// We don't use std::priority_queue because we need to be able to serialize, unserialize and
-// erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't accomodated
-// by the standard adaptor class.
+// The queue is a min-heap, maintained by hand rather than with std::push_heap/pop_heap so that
+// every move of an event also updates its slot. This lets a handle find its event in O(1) and
+// remove it in O(log n). We don't use std::priority_queue because we need to be able to
+// serialize, unserialize and erase arbitrary events regardless of the queue order.
 static std::vector<Event> event_queue;
+static std::vector<EventSlot> event_slots;
+static std::vector<u32> free_event_slots;
 static u64 event_fifo_id;
-// the queue for storing the events from other threads threadsafe until they will be added
+// the lock-free queue for storing the events from other threads until they will be added
 // to the event_queue by the emu thread
 static Common::MPSCQueue<Event, false> ts_queue;
 
@@ -70,6 +80,115 @@ static EventType* ev_lost = nullptr;
 
 static void EmptyTimedCallback(u64 userdata, s64 cyclesLate) {}
 
+static EventHandle MakeHandle(u32 slot) {
+    // Slot indices are offset by one so that a valid handle is never INVALID_EVENT_HANDLE
+    return (static_cast<u64>(event_slots[slot].generation) << 32) | (slot + 1);
+}
+
+static u32 AllocateSlot() {
+    if (free_event_slots.empty()) {
+        event_slots.push_back(EventSlot{0, 0, true});
+        return static_cast<u32>(event_slots.size() - 1);
+    }
+
+    const u32 slot = free_event_slots.back();
+    free_event_slots.pop_back();
+    event_slots[slot].in_use = true;
+    return slot;
+}
+
+static void FreeSlot(u32 slot) {
+    event_slots[slot].in_use = false;
+    ++event_slots[slot].generation;
+    free_event_slots.push_back(slot);
+}
+
+/// Stores an event at the given position of the queue and records that position in its slot
+static void PlaceEvent(size_t index, Event&& event) {
+    event_slots[event.slot].queue_index = static_cast<u32>(index);
+    event_queue[index] = std::move(event);
+}
+
+static void SiftUp(size_t index) {
+    Event event = std::move(event_queue[index]);
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!(event < event_queue[parent])) {
+            break;
+        }
+        PlaceEvent(index, std::move(event_queue[parent]));
+        index = parent;
+    }
+    PlaceEvent(index, std::move(event));
+}
+
+static void SiftDown(size_t index) {
+    Event event = std::move(event_queue[index]);
+    const size_t size = event_queue.size();
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && event_queue[child + 1] < event_queue[child]) {
+            ++child;
+        }
+        if (!(event_queue[child] < event)) {
+            break;
+        }
+        PlaceEvent(index, std::move(event_queue[child]));
+        index = child;
+    }
+    PlaceEvent(index, std::move(event));
+}
+
+static EventHandle PushEvent(Event event) {
+    const u32 slot = AllocateSlot();
+    event.slot = slot;
+    event_queue.emplace_back(std::move(event));
+    SiftUp(event_queue.size() - 1);
+    return MakeHandle(slot);
+}
+
+/// Removes the event at the given position of the queue, keeping the heap property intact
+static Event RemoveEventAt(size_t index) {
+    Event removed = std::move(event_queue[index]);
+    FreeSlot(removed.slot);
+
+    Event last = std::move(event_queue.back());
+    event_queue.pop_back();
+    if (index < event_queue.size()) {
+        PlaceEvent(index, std::move(last));
+        if (index > 0 && event_queue[index] < event_queue[(index - 1) / 2]) {
+            SiftUp(index);
+        } else {
+            SiftDown(index);
+        }
+    }
+    return removed;
+}
+
+/// Removes all the events matching the predicate. This is O(n), and only used by the slow paths.
+template <typename Predicate>
+static void RemoveEventsIf(Predicate pred) {
+    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
+        if (!pred(e)) {
+            return false;
+        }
+        FreeSlot(e.slot);
+        return true;
+    });
+
+    // Removing random items breaks the invariant so we have to re-establish it.
+    if (itr != event_queue.end()) {
+        event_queue.erase(itr, event_queue.end());
+        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+        for (size_t index = 0; index < event_queue.size(); ++index) {
+            event_slots[event_queue[index].slot].queue_index = static_cast<u32>(index);
+        }
+    }
+}
+
 EventType* RegisterEvent(const std::string& name, TimedCallback callback) {
     // check for existing type with same name.
     // we want event type names to remain unique so that we can use them for serialization.
@@ -130,10 +249,13 @@ u64 GetIdleTicks() {
 }
 
 void ClearPendingEvents() {
+    for (const Event& event : event_queue) {
+        FreeSlot(event.slot);
+    }
     event_queue.clear();
 }
 
-void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
+EventHandle ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
     ASSERT(event_type != nullptr);
     s64 timeout = GetTicks() + cycles_into_future;
 
@@ -141,35 +263,36 @@ void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 user
     if (!is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
 
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+    return PushEvent(Event{timeout, event_fifo_id++, userdata, event_type, 0});
 }
 
 void ScheduleEventThreadsafe(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
-    ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type});
+    ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type, 0});
 }
 
 void UnscheduleEvent(const EventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
+    RemoveEventsIf(
+        [&](const Event& e) { return e.type == event_type && e.userdata == userdata; });
+}
 
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+void UnscheduleEvent(EventHandle handle) {
+    if (handle == INVALID_EVENT_HANDLE) {
+        return;
+    }
+
+    const u32 slot = static_cast<u32>(handle & 0xFFFFFFFF) - 1;
+    const u32 generation = static_cast<u32>(handle >> 32);
+    if (slot >= event_slots.size() || !event_slots[slot].in_use ||
+        event_slots[slot].generation != generation) {
+        // The event has already fired or been unscheduled
+        return;
     }
+
+    RemoveEventAt(event_slots[slot].queue_index);
 }
 
 void RemoveEvent(const EventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
-    }
+    RemoveEventsIf([&](const Event& e) { return e.type == event_type; });
 }
 
 void RemoveNormalAndThreadsafeEvent(const EventType* event_type) {
@@ -190,8 +313,7 @@ void ForceExceptionCheck(s64 cycles) {
 void MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+        PushEvent(std::move(ev));
     }
 }
 
@@ -205,9 +327,7 @@ void Advance() {
     is_global_timer_sane = true;
 
     while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
-        event_queue.pop_back();
+        Event evt = RemoveEventAt(0);
         evt.type->callback(evt.userdata, global_timer - evt.time);
     }
 
@@ -223,8 +343,12 @@ void Advance() {
 }
 
 void Idle() {
-    idled_cycles += downcount;
-    downcount = 0;
+    Idle(downcount);
+}
+
+void Idle(int cycles) {
+    idled_cycles += cycles;
+    downcount -= cycles;
 }
 
 u64 GetGlobalTimeUs() {
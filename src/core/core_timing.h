@@ -138,6 +138,13 @@ void AddTicks(u64 ticks);
 
 struct EventType;
 
+/**
+ * Identifies a single scheduled event, allowing it to be unscheduled in O(log n) without searching
+ * the queue. Handles of events that have already fired or been unscheduled are simply ignored.
+ */
+using EventHandle = u64;
+constexpr EventHandle INVALID_EVENT_HANDLE = 0;
+
 /**
  * Returns the event_type identifier. if name is not unique, it will assert.
  */
@@ -149,18 +156,23 @@ void UnregisterAllEvents();
  * is scheduled earlier than the current values.
  * Scheduling from a callback will not update the downcount until the Advance() completes.
  */
-void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata = 0);
+EventHandle ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata = 0);
 
 /**
  * This is to be called when outside of hle threads, such as the graphics thread, wants to
- * schedule things to be executed on the main thread.
+ * schedule things to be executed on the main thread. It never blocks: events are pushed to a
+ * lock-free inbox that the main thread drains at the start of every slice.
  * Not that this doesn't change slice_length and thus events scheduled by this might be called
  * with a delay of up to MAX_SLICE_LENGTH
  */
 void ScheduleEventThreadsafe(s64 cycles_into_future, const EventType* event_type, u64 userdata);
 
+/// Unschedules every event of the given type and userdata. This searches the whole queue.
 void UnscheduleEvent(const EventType* event_type, u64 userdata);
 
+/// Unschedules the event identified by the handle returned when it was scheduled
+void UnscheduleEvent(EventHandle handle);
+
 /// We only permit one event of each type in the queue at a time.
 void RemoveEvent(const EventType* event_type);
 void RemoveNormalAndThreadsafeEvent(const EventType* event_type);
@@ -177,6 +189,9 @@ void MoveEvents();
 /// Pretend that the main CPU has executed enough cycles to reach the next event.
 void Idle();
 
+/// Pretend that the main CPU has executed the given number of cycles, without running them.
+void Idle(int cycles);
+
 /// Clear all pending events. This should ONLY be done on exit.
 void ClearPendingEvents();
 
@@ -8,6 +8,8 @@
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include "common/alignment.h"
+#include "common/assert.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/domain.h"
 #include "core/hle/kernel/handle_table.h"
@@ -313,4 +315,167 @@ Kernel::SharedPtr<T> RequestParser::GetCopyObject(size_t index) {
     return context->GetCopyObject<T>(index);
 }
 
+/// Input buffer sent by the client through an A descriptor, for marshalled handlers
+struct InBuffer {
+    VAddr address;
+    u64 size;
+};
+
+/// Output buffer sent by the client through a B descriptor, for marshalled handlers
+struct OutBuffer {
+    VAddr address;
+    u64 size;
+};
+
+/// Buffer sent by the client through an X (pointer) descriptor, for marshalled handlers
+struct InPointer {
+    VAddr address;
+    u64 size;
+};
+
+namespace Detail {
+
+/**
+ * Classifies a parameter of a marshalled handler. Parameters taken by value or by const reference
+ * are read from the request, while parameters taken by non-const reference are written to the
+ * response after the handler returns.
+ */
+template <typename Arg>
+struct MarshalArg {
+    using Type = std::remove_cv_t<std::remove_reference_t<Arg>>;
+    static constexpr bool is_output =
+        std::is_lvalue_reference_v<Arg> && !std::is_const_v<std::remove_reference_t<Arg>>;
+    static constexpr bool is_buffer = std::is_same_v<Type, InBuffer> ||
+                                      std::is_same_v<Type, OutBuffer> ||
+                                      std::is_same_v<Type, InPointer>;
+
+    static_assert(!(is_output && is_buffer), "Buffer descriptors can only be inputs");
+    static_assert(std::is_trivially_copyable_v<Type>, "Raw parameters must be trivially copyable");
+
+    /// Size of the parameter in the raw data, in words
+    static constexpr u32 words = static_cast<u32>((sizeof(Type) + 3) / 4);
+    /// 64-bit parameters are aligned to 8 bytes relative to the start of the parameters
+    static constexpr u32 alignment = alignof(Type) >= 8 ? 2 : 1;
+};
+
+/// Returns the offset, in words, right after the given output parameter
+template <typename Arg>
+constexpr u32 AdvanceOutput(u32 offset) {
+    using Traits = MarshalArg<Arg>;
+    if constexpr (Traits::is_output) {
+        return Common::AlignUp(offset, Traits::alignment) + Traits::words;
+    } else {
+        return offset;
+    }
+}
+
+/// Size, in words, of the outputs of a handler taking the given parameters
+template <typename... Args>
+constexpr u32 OutputWords() {
+    u32 offset = 0;
+    ((offset = AdvanceOutput<Args>(offset)), ...);
+    return offset;
+}
+
+/// Position of a marshalled handler in the raw data and buffer descriptor lists of a request
+struct MarshalState {
+    u32 raw_offset = 0; ///< In words, relative to the first parameter
+    size_t num_a_buffers = 0;
+    size_t num_b_buffers = 0;
+    size_t num_x_buffers = 0;
+};
+
+template <typename Buffer, typename List>
+Buffer GetMarshalledBuffer(const List& descriptors, size_t& index) {
+    ASSERT_MSG(index < descriptors.size(), "Request is missing a buffer descriptor");
+    const auto& descriptor = descriptors[index++];
+    return {descriptor.Address(), descriptor.Size()};
+}
+
+/// Reads the next input parameter of a marshalled handler
+template <typename Arg>
+typename MarshalArg<Arg>::Type PopMarshalled(RequestParser& rp, Kernel::HLERequestContext& ctx,
+                                             MarshalState& state) {
+    using Traits = MarshalArg<Arg>;
+    using T = typename Traits::Type;
+
+    if constexpr (Traits::is_output) {
+        return T{};
+    } else if constexpr (std::is_same_v<T, InBuffer>) {
+        return GetMarshalledBuffer<T>(ctx.BufferDescriptorA(), state.num_a_buffers);
+    } else if constexpr (std::is_same_v<T, OutBuffer>) {
+        return GetMarshalledBuffer<T>(ctx.BufferDescriptorB(), state.num_b_buffers);
+    } else if constexpr (std::is_same_v<T, InPointer>) {
+        ASSERT_MSG(state.num_x_buffers < ctx.BufferDescriptorX().size(),
+                   "Request is missing a buffer descriptor");
+        const auto& descriptor = ctx.BufferDescriptorX()[state.num_x_buffers++];
+        return {descriptor.Address(), descriptor.size.Value()};
+    } else {
+        const u32 padding = Common::AlignUp(state.raw_offset, Traits::alignment) - state.raw_offset;
+        rp.Skip(padding, false);
+        state.raw_offset += padding + Traits::words;
+        if constexpr (std::is_same_v<T, bool>) {
+            return rp.Pop<bool>();
+        } else {
+            return rp.PopRaw<T>();
+        }
+    }
+}
+
+/// Writes an output parameter of a marshalled handler to the response
+template <typename Arg>
+void PushMarshalled(RequestBuilder& rb, const typename MarshalArg<Arg>::Type& value,
+                    u32& raw_offset) {
+    using Traits = MarshalArg<Arg>;
+
+    if constexpr (Traits::is_output) {
+        const u32 padding = Common::AlignUp(raw_offset, Traits::alignment) - raw_offset;
+        rb.Skip(padding, true);
+        raw_offset += padding + Traits::words;
+        rb.PushRaw(value);
+    }
+}
+
+template <typename Self, typename... Args, size_t... I>
+void InvokeMarshalledImpl(Self* self, ResultCode (Self::*handler)(Args...),
+                          Kernel::HLERequestContext& ctx, std::index_sequence<I...>) {
+    RequestParser rp{ctx};
+    MarshalState state;
+    // Braced initialization guarantees that the parameters are read from left to right
+    std::tuple<typename MarshalArg<Args>::Type...> values{
+        PopMarshalled<Args>(rp, ctx, state)...};
+
+    const ResultCode result = (self->*handler)(std::get<I>(values)...);
+    if (result.IsError()) {
+        RequestBuilder rb{ctx, 2};
+        rb.Push(result);
+        return;
+    }
+
+    constexpr u32 output_words = OutputWords<Args...>();
+    RequestBuilder rb{ctx, 2 + output_words};
+    rb.Push(result);
+    u32 raw_offset = 0;
+    (PushMarshalled<Args>(rb, std::get<I>(values), raw_offset), ...);
+}
+
+} // namespace Detail
+
+/**
+ * Invokes a handler whose request and response layouts are described by its signature, which must
+ * be of the form `ResultCode Handler(Args...)`:
+ * - Arguments taken by value or const reference are read in order from the raw data of the
+ *   request. InBuffer, OutBuffer and InPointer arguments are instead filled in order from the A, B
+ *   and X buffer descriptors respectively.
+ * - Arguments taken by non-const reference are outputs, written in order to the raw data of the
+ *   response when the handler succeeds. On failure, only the result code is sent back.
+ * 64-bit values are aligned to 8 bytes in the raw data, as done by the real services. The size of
+ * the response is known at compile time.
+ */
+template <typename Self, typename... Args>
+void InvokeMarshalled(Self* self, ResultCode (Self::*handler)(Args...),
+                      Kernel::HLERequestContext& ctx) {
+    Detail::InvokeMarshalledImpl(self, handler, ctx, std::index_sequence_for<Args...>{});
+}
+
 } // namespace IPC
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
 #include "common/assert.h"
 #include "core/hle/kernel/condition_variable.h"
 #include "core/hle/kernel/errors.h"
@@ -44,7 +46,7 @@ ResultCode ConditionVariable::Release(s32 target) {
     if (target == -1) {
         // When -1, wake up all waiting threads
         SetAvailableCount(GetWaitingThreads().size());
-        WakeupAllWaitingThreads();
+        WakeupAllWaitingThreadsByPriority();
     } else {
         // Otherwise, wake up just a single thread
         SetAvailableCount(target);
@@ -54,6 +56,27 @@ ResultCode ConditionVariable::Release(s32 target) {
     return RESULT_SUCCESS;
 }
 
+void ConditionVariable::WakeupAllWaitingThreadsByPriority() {
+    // Threads can only wait on a condition variable through WaitProcessWideKeyAtomic, which waits
+    // on it alone, so every waiter can be woken up in a single priority ordered pass instead of
+    // searching the waiters for the best one again after each wakeup.
+    std::vector<SharedPtr<Thread>> waiters = GetWaitingThreads();
+    if (std::any_of(waiters.begin(), waiters.end(), [](const SharedPtr<Thread>& thread) {
+            return thread->status != THREADSTATUS_WAIT_SYNCH_ANY;
+        })) {
+        WakeupAllWaitingThreads();
+        return;
+    }
+
+    std::stable_sort(waiters.begin(), waiters.end(),
+                     [](const SharedPtr<Thread>& a, const SharedPtr<Thread>& b) {
+                         return a->current_priority < b->current_priority;
+                     });
+    for (auto& thread : waiters) {
+        WakeupWaitingThread(thread);
+    }
+}
+
 s32 ConditionVariable::GetAvailableCount() const {
     return Memory::Read32(guest_addr);
 }
@@ -60,6 +60,9 @@ public:
 private:
     ConditionVariable();
     ~ConditionVariable() override;
+
+    /// Wakes up all the waiting threads, from the highest to the lowest priority.
+    void WakeupAllWaitingThreadsByPriority();
 };
 
 } // namespace Kernel
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <utility>
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -17,20 +18,106 @@ namespace Kernel {
 
 HandleTable g_handle_table;
 
+/// Bit mask of the reader indices currently owned by a host thread
+static std::atomic<u32> used_reader_indices{0};
+
+size_t HandleTable::GetReaderIndex() {
+    static_assert(MAX_READERS <= 32, "The reader indices don't fit in the mask");
+
+    /// Owns a reader index for the lifetime of a host thread
+    struct ReaderIndex {
+        ~ReaderIndex() {
+            // The thread is outside of any ReadGuard, so its epoch is already inactive
+            if (index < MAX_READERS) {
+                used_reader_indices.fetch_and(~(1U << index));
+            }
+        }
+        size_t index = MAX_READERS;
+    };
+    thread_local ReaderIndex reader_index;
+
+    if (reader_index.index < MAX_READERS) {
+        return reader_index.index;
+    }
+
+    // Threads which found every index taken try again, another thread may have exited since
+    u32 used = used_reader_indices.load();
+    while (used != (1U << MAX_READERS) - 1) {
+        size_t index = 0;
+        while ((used >> index) & 1) {
+            ++index;
+        }
+        if (used_reader_indices.compare_exchange_weak(used, used | (1U << index))) {
+            reader_index.index = index;
+            break;
+        }
+    }
+    return reader_index.index;
+}
+
+HandleTable::ReadGuard::ReadGuard(const HandleTable& table)
+    : table(table), reader_index(GetReaderIndex()) {
+    if (reader_index >= MAX_READERS) {
+        // Untracked thread, exclude the writers for the duration of the read instead
+        table.mutex.lock();
+        locked = true;
+        return;
+    }
+
+    auto& reader_epoch = table.reader_epochs[reader_index];
+    if (reader_epoch.load(std::memory_order_relaxed) != INACTIVE_EPOCH) {
+        // Nested guard, the outermost one already protects the reads
+        return;
+    }
+
+    outermost = true;
+    reader_epoch.store(table.global_epoch.load());
+    // The slots must not be read before the epoch is published, see ReclaimRetiredObjects
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+HandleTable::ReadGuard::~ReadGuard() {
+    if (locked) {
+        table.mutex.unlock();
+    } else if (outermost) {
+        table.reader_epochs[reader_index].store(INACTIVE_EPOCH, std::memory_order_release);
+    }
+}
+
 HandleTable::HandleTable() {
-    next_generation = 1;
+    for (auto& reader_epoch : reader_epochs) {
+        reader_epoch.store(INACTIVE_EPOCH, std::memory_order_relaxed);
+    }
+}
+
+HandleTable::~HandleTable() {
     Clear();
+    // Nothing can read from the table anymore
+    retired_objects.clear();
+    for (auto& chunk : chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
 }
 
 ResultVal<Handle> HandleTable::Create(SharedPtr<Object> obj) {
     DEBUG_ASSERT(obj != nullptr);
 
-    u16 slot = next_free_slot;
-    if (slot >= generations.size()) {
-        LOG_ERROR(Kernel, "Unable to allocate Handle, too many slots in use.");
-        return ERR_OUT_OF_HANDLES;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    const u32 slot_index = next_free_slot;
+    if (slot_index == num_slots) {
+        // The free list is empty, grow the table
+        if (num_slots == MAX_COUNT) {
+            LOG_ERROR(Kernel, "Unable to allocate Handle, too many slots in use.");
+            return ERR_OUT_OF_HANDLES;
+        }
+        if (num_slots % CHUNK_SIZE == 0) {
+            chunks[num_slots / CHUNK_SIZE].store(new Slot[CHUNK_SIZE], std::memory_order_release);
+        }
+        next_free_slot = ++num_slots;
+    } else {
+        next_free_slot = GetSlotPointer(slot_index)->next_free_slot;
     }
-    next_free_slot = generations[slot];
 
     u16 generation = next_generation++;
 
@@ -39,10 +126,13 @@ ResultVal<Handle> HandleTable::Create(SharedPtr<Object> obj) {
     if (next_generation >= (1 << 15))
         next_generation = 1;
 
-    generations[slot] = generation;
-    objects[slot] = std::move(obj);
+    // Publish the object before the generation, readers check the generation last
+    Slot& slot = *GetSlotPointer(slot_index);
+    slot.object.store(obj.get(), std::memory_order_release);
+    slot.owner = std::move(obj);
+    slot.generation.store(generation, std::memory_order_release);
 
-    Handle handle = generation | (slot << 15);
+    Handle handle = generation | (slot_index << 15);
     return MakeResult<Handle>(handle);
 }
 
@@ -56,52 +146,129 @@ ResultVal<Handle> HandleTable::Duplicate(Handle handle) {
 }
 
 void HandleTable::ConvertSessionToDomain(const Session& session, SharedPtr<Object> domain) {
-    for (auto& object : objects) {
-        if (DynamicObjectCast<ClientSession>(object) == session.client) {
-            object = domain;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    for (u32 i = 0; i < num_slots; ++i) {
+        Slot& slot = *GetSlotPointer(i);
+        if (slot.owner == nullptr) {
+            continue;
+        }
+        if (DynamicObjectCast<ClientSession>(slot.owner) == session.client) {
+            slot.object.store(domain.get(), std::memory_order_release);
+            RetireOwner(slot);
+            slot.owner = domain;
         }
     }
+    ReclaimRetiredObjects();
 }
 
 ResultCode HandleTable::Close(Handle handle) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     if (!IsValid(handle))
         return ERR_INVALID_HANDLE;
 
-    u16 slot = GetSlot(handle);
+    const u32 slot_index = GetSlot(handle);
+    Slot& slot = *GetSlotPointer(slot_index);
+    slot.generation.store(0, std::memory_order_release);
+    slot.object.store(nullptr, std::memory_order_release);
+    RetireOwner(slot);
 
-    objects[slot] = nullptr;
+    slot.next_free_slot = next_free_slot;
+    next_free_slot = slot_index;
 
-    generations[slot] = next_free_slot;
-    next_free_slot = slot;
+    ReclaimRetiredObjects();
     return RESULT_SUCCESS;
 }
 
 bool HandleTable::IsValid(Handle handle) const {
-    size_t slot = GetSlot(handle);
-    u16 generation = GetGeneration(handle);
-
-    return slot < MAX_COUNT && objects[slot] != nullptr && generations[slot] == generation;
+    ReadGuard guard(*this);
+    return LookupSlot(handle) != nullptr;
 }
 
-SharedPtr<Object> HandleTable::GetGeneric(Handle handle) const {
+Object* HandleTable::Lookup(Handle handle) const {
     if (handle == CurrentThread) {
         return GetCurrentThread();
     } else if (handle == CurrentProcess) {
-        return g_current_process;
+        return GetCurrentProcess();
     }
+    return LookupSlot(handle);
+}
 
-    if (!IsValid(handle)) {
-        return nullptr;
-    }
-    return objects[GetSlot(handle)];
+SharedPtr<Object> HandleTable::GetGeneric(Handle handle) const {
+    ReadGuard guard(*this);
+    return SharedPtr<Object>(Lookup(handle));
 }
 
 void HandleTable::Clear() {
-    for (u16 i = 0; i < MAX_COUNT; ++i) {
-        generations[i] = i + 1;
-        objects[i] = nullptr;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    for (u32 i = 0; i < num_slots; ++i) {
+        Slot& slot = *GetSlotPointer(i);
+        if (slot.owner != nullptr) {
+            slot.generation.store(0, std::memory_order_release);
+            slot.object.store(nullptr, std::memory_order_release);
+            RetireOwner(slot);
+        }
+        slot.next_free_slot = i + 1;
     }
     next_free_slot = 0;
+
+    ReclaimRetiredObjects();
+}
+
+HandleTable::Slot* HandleTable::GetSlotPointer(u32 slot) const {
+    if (slot >= MAX_COUNT) {
+        return nullptr;
+    }
+    Slot* chunk = chunks[slot / CHUNK_SIZE].load(std::memory_order_acquire);
+    return chunk == nullptr ? nullptr : &chunk[slot % CHUNK_SIZE];
+}
+
+Object* HandleTable::LookupSlot(Handle handle) const {
+    const Slot* slot = GetSlotPointer(GetSlot(handle));
+    if (slot == nullptr) {
+        return nullptr;
+    }
+
+    const u16 generation = slot->generation.load(std::memory_order_acquire);
+    Object* object = slot->object.load(std::memory_order_acquire);
+    if (object == nullptr || generation != GetGeneration(handle)) {
+        return nullptr;
+    }
+
+    // The handle may have been closed and its slot reused while the object was being read
+    if (slot->generation.load(std::memory_order_acquire) != generation) {
+        return nullptr;
+    }
+    return object;
+}
+
+void HandleTable::RetireOwner(Slot& slot) {
+    // Readers that publish their epoch after this increment can't see the old object anymore
+    const u64 epoch = global_epoch.fetch_add(1);
+    retired_objects.push_back({std::move(slot.owner), epoch});
+}
+
+void HandleTable::ReclaimRetiredObjects() {
+    u64 oldest_reader_epoch = INACTIVE_EPOCH;
+    for (const auto& reader_epoch : reader_epochs) {
+        oldest_reader_epoch = std::min(oldest_reader_epoch, reader_epoch.load());
+    }
+
+    // Objects are retired in epoch order, release the ones that are older than every reader.
+    // They are moved out first, as destroying them may close other handles.
+    const auto first_in_use = std::find_if(
+        retired_objects.begin(), retired_objects.end(),
+        [oldest_reader_epoch](const RetiredObject& retired) {
+            return retired.epoch >= oldest_reader_epoch;
+        });
+    if (first_in_use == retired_objects.begin()) {
+        return;
+    }
+    std::vector<RetiredObject> reclaimed(std::make_move_iterator(retired_objects.begin()),
+                                         std::make_move_iterator(first_in_use));
+    retired_objects.erase(retired_objects.begin(), first_in_use);
 }
 
-} // namespace
+} // namespace Kernel
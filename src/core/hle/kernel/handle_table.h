@@ -5,7 +5,10 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <mutex>
+#include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/result.h"
@@ -31,20 +34,37 @@ class Session;
  *
  * To prevent accidental use of a freed Handle whose slot has already been reused, a global counter
  * is kept and incremented every time a Handle is created. This is the Handle's "generation". The
- * value of the counter is stored into the Handle as well as in the handle table (in the
- * "generations" array). When looking up a handle, the Handle's generation must match with the
- * value stored on the class, otherwise the Handle is considered invalid.
+ * value of the counter is stored into the Handle as well as in the handle table. When looking up a
+ * handle, the Handle's generation must match with the value stored on the class, otherwise the
+ * Handle is considered invalid.
  *
- * To find free slots when allocating a Handle without needing to scan the entire object array, the
- * generations field of unallocated slots is re-purposed as a linked list of indices to free slots.
- * When a Handle is created, an index is popped off the list and used for the new Handle. When it
- * is destroyed, it is again pushed onto the list to be re-used by the next allocation. It is
- * likely that this allocation strategy differs from the one used in CTR-OS, but this hasn't been
- * verified and isn't likely to cause any problems.
+ * Lookups never take a lock, so that the CPU cores can resolve handles concurrently. Slots are
+ * allocated in chunks which are never moved or freed while the table lives, which lets the table
+ * grow without invalidating concurrent readers. Readers announce themselves with a ReadGuard, and
+ * objects whose handle is closed are only released once every reader which could still have seen
+ * them has left (epoch-based reclamation). Modifications are serialized by a mutex.
  */
 class HandleTable final : NonCopyable {
 public:
     HandleTable();
+    ~HandleTable();
+
+    /**
+     * Marks the calling host thread as reading from the table for the lifetime of the guard.
+     * Objects looked up with Lookup() stay alive at least until the guard is destroyed. Guards
+     * may be nested.
+     */
+    class ReadGuard final : NonCopyable {
+    public:
+        explicit ReadGuard(const HandleTable& table);
+        ~ReadGuard();
+
+    private:
+        const HandleTable& table;
+        size_t reader_index;
+        bool outermost = false;
+        bool locked = false;
+    };
 
     /**
      * Allocates a handle for the given object.
@@ -77,7 +97,29 @@ public:
     bool IsValid(Handle handle) const;
 
     /**
-     * Looks up a handle.
+     * Looks up a handle without touching the object's ref-count. Must be called with a ReadGuard
+     * of this table alive, which keeps the returned object alive.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid.
+     */
+    Object* Lookup(Handle handle) const;
+
+    /**
+     * Looks up a handle while verifying its type, without touching the object's ref-count. Must be
+     * called with a ReadGuard of this table alive.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid or its
+     *         type differs from the requested one.
+     */
+    template <class T>
+    T* Lookup(Handle handle) const {
+        Object* object = Lookup(handle);
+        if (object != nullptr && object->GetHandleType() == T::HANDLE_TYPE) {
+            return static_cast<T*>(object);
+        }
+        return nullptr;
+    }
+
+    /**
+     * Looks up a handle and takes a reference to the object, which needs HLE::g_hle_lock held.
      * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid.
      */
     SharedPtr<Object> GetGeneric(Handle handle) const;
@@ -96,36 +138,94 @@ public:
     void Clear();
 
 private:
+    /// Number of slots allocated at once when the table grows.
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    /**
+     * Maximum number of handles, limited by the 17 bits of the slot index. The last index is taken
+     * by the CurrentThread and CurrentProcess pseudo-handles.
+     */
+    static constexpr size_t MAX_COUNT = (1 << 17) - 1;
+    static constexpr size_t MAX_CHUNKS = (MAX_COUNT + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    /**
+     * Maximum number of host threads tracked by the epoch reclamation at the same time. A thread
+     * gives its index back when it exits. Lookups from threads without an index fall back to
+     * taking the table's mutex.
+     */
+    static constexpr size_t MAX_READERS = 16;
+
+    /// Epoch value of a reader which isn't inside a ReadGuard.
+    static constexpr u64 INACTIVE_EPOCH = ~0ULL;
+
     /**
-     * This is the maximum limit of handles allowed per process in CTR-OS. It can be further
-     * reduced by ExHeader values, but this is not emulated here.
+     * Returns the index of the calling host thread in the reader epoch arrays of the handle
+     * tables, or MAX_READERS if all of them are taken by other threads.
      */
-    static const size_t MAX_COUNT = 4096;
+    static size_t GetReaderIndex();
 
-    static u16 GetSlot(Handle handle) {
+    static u32 GetSlot(Handle handle) {
         return handle >> 15;
     }
     static u16 GetGeneration(Handle handle) {
         return handle & 0x7FFF;
     }
 
-    /// Stores the Object referenced by the handle or null if the slot is empty.
-    std::array<SharedPtr<Object>, MAX_COUNT> objects;
+    struct Slot {
+        /// Object referenced by the handle, read without locking. Null if the slot is empty.
+        std::atomic<Object*> object{nullptr};
+        /// The value of `next_generation` when the handle was created, 0 for empty slots.
+        std::atomic<u16> generation{0};
+        /// Reference keeping `object` alive, only accessed with the mutex held.
+        SharedPtr<Object> owner;
+        /// For empty slots, the index of the next free slot in the list.
+        u32 next_free_slot = 0;
+    };
 
-    /**
-     * The value of `next_generation` when the handle was created, used to check for validity. For
-     * empty slots, contains the index of the next free slot in the list.
-     */
-    std::array<u16, MAX_COUNT> generations;
+    /// An object whose handle was closed, released once no reader can reference it anymore.
+    struct RetiredObject {
+        SharedPtr<Object> object;
+        u64 epoch;
+    };
+
+    /// Returns the slot with the given index, or null if it has not been allocated yet.
+    Slot* GetSlotPointer(u32 slot) const;
+
+    /// Looks up a handle which isn't a pseudo-handle. Needs a ReadGuard alive.
+    Object* LookupSlot(Handle handle) const;
+
+    /// Defers the release of a slot's object. Must be called with the mutex held.
+    void RetireOwner(Slot& slot);
+
+    /// Releases the retired objects that no reader can reference anymore. Needs the mutex held.
+    void ReclaimRetiredObjects();
+
+    /// Chunks of slots, allocated on demand and only freed when the table is destroyed.
+    std::array<std::atomic<Slot*>, MAX_CHUNKS> chunks{};
+
+    /// Number of slots that have ever been allocated, all the slots below this have a chunk.
+    u32 num_slots = 0;
 
     /**
-     * Global counter of the number of created handles. Stored in `generations` when a handle is
+     * Global counter of the number of created handles. Stored in the slot when a handle is
      * created, and wraps around to 1 when it hits 0x8000.
      */
-    u16 next_generation;
+    u16 next_generation = 1;
+
+    /// Head of the free slots linked list, `num_slots` when the list is empty.
+    u32 next_free_slot = 0;
+
+    /// Current reclamation epoch, advanced every time an object is retired.
+    std::atomic<u64> global_epoch{0};
+
+    /// Epoch observed by each reader thread when it entered its ReadGuard.
+    mutable std::array<std::atomic<u64>, MAX_READERS> reader_epochs;
+
+    /// Objects waiting for the readers that may reference them to leave.
+    std::vector<RetiredObject> retired_objects;
 
-    /// Head of the free slots linked list.
-    u16 next_free_slot;
+    /// Serializes the modifications of the table, recursive as releasing objects may close handles.
+    mutable std::recursive_mutex mutex;
 };
 
 extern HandleTable g_handle_table;
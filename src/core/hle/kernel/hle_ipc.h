@@ -4,10 +4,10 @@
 
 #pragma once
 
-#include <array>
 #include <memory>
 #include <vector>
 #include <boost/container/small_vector.hpp>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/ipc.h"
@@ -83,16 +83,28 @@ protected:
  * The end result is similar to just giving services their own real handle tables, but since these
  * ids are local to a specific context, it avoids requiring services to manage handles for objects
  * across multiple calls and ensuring that unneeded handles are cleaned up.
+ *
+ * Zero-copy protocol
+ * ==================
+ *
+ * IPC is on the hot path of most games, so a context never allocates for a typical request: the
+ * headers are stored inline and the descriptor and object lists have enough inline capacity for
+ * common usage. The context also does not copy the command buffer. It parses the requester's TLS
+ * in place, and the response is built directly on top of the request once the handler has read
+ * its parameters.
  */
 class HLERequestContext {
 public:
+    using BufferDescriptorXList = boost::container::small_vector<IPC::BufferDescriptorX, 4>;
+    using BufferDescriptorABWList = boost::container::small_vector<IPC::BufferDescriptorABW, 4>;
+
     HLERequestContext(SharedPtr<Kernel::Domain> domain);
     HLERequestContext(SharedPtr<Kernel::ServerSession> session);
     ~HLERequestContext();
 
     /// Returns a pointer to the IPC command buffer for this request.
     u32* CommandBuffer() {
-        return cmd_buf.data();
+        return cmd_buf;
     }
 
     /**
@@ -112,7 +124,10 @@ public:
 
     void ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming);
 
-    /// Populates this context with data from the requesting process/thread.
+    /**
+     * Populates this context with data from the requesting process/thread. The command buffer is
+     * used in place and must stay valid until the response has been written.
+     */
     ResultCode PopulateFromIncomingCommandBuffer(u32_le* src_cmdbuf, Process& src_process,
                                                  HandleTable& src_table);
     /// Writes data from this context back to the requesting process/thread.
@@ -131,19 +146,19 @@ public:
         return data_payload_offset;
     }
 
-    const std::vector<IPC::BufferDescriptorX>& BufferDescriptorX() const {
+    const BufferDescriptorXList& BufferDescriptorX() const {
         return buffer_x_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorABW>& BufferDescriptorA() const {
+    const BufferDescriptorABWList& BufferDescriptorA() const {
         return buffer_a_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorABW>& BufferDescriptorB() const {
+    const BufferDescriptorABWList& BufferDescriptorB() const {
         return buffer_b_desciptors;
     }
 
-    const std::unique_ptr<IPC::DomainMessageHeader>& GetDomainMessageHeader() const {
+    const boost::optional<IPC::DomainMessageHeader>& GetDomainMessageHeader() const {
         return domain_message_header;
     }
 
@@ -176,7 +191,8 @@ public:
     }
 
 private:
-    std::array<u32, IPC::COMMAND_BUFFER_LENGTH> cmd_buf;
+    /// Command buffer of the request, in the requesting thread's TLS
+    u32* cmd_buf = nullptr;
     SharedPtr<Kernel::Domain> domain;
     SharedPtr<Kernel::ServerSession> server_session;
     // TODO(yuriks): Check common usage of this and optimize size accordingly
@@ -184,14 +200,14 @@ private:
     boost::container::small_vector<SharedPtr<Object>, 8> copy_objects;
     boost::container::small_vector<std::shared_ptr<SessionRequestHandler>, 8> domain_objects;
 
-    std::unique_ptr<IPC::CommandHeader> command_header;
-    std::unique_ptr<IPC::HandleDescriptorHeader> handle_descriptor_header;
-    std::unique_ptr<IPC::DataPayloadHeader> data_payload_header;
-    std::unique_ptr<IPC::DomainMessageHeader> domain_message_header;
-    std::vector<IPC::BufferDescriptorX> buffer_x_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_a_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_b_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_w_desciptors;
+    boost::optional<IPC::CommandHeader> command_header;
+    boost::optional<IPC::HandleDescriptorHeader> handle_descriptor_header;
+    boost::optional<IPC::DataPayloadHeader> data_payload_header;
+    boost::optional<IPC::DomainMessageHeader> domain_message_header;
+    BufferDescriptorXList buffer_x_desciptors;
+    BufferDescriptorABWList buffer_a_desciptors;
+    BufferDescriptorABWList buffer_b_desciptors;
+    BufferDescriptorABWList buffer_w_desciptors;
 
     unsigned data_payload_offset{};
     u32_le command{};
@@ -41,7 +41,7 @@ void Shutdown() {
     g_object_address_table.Clear();
 
     Kernel::ThreadingShutdown();
-    g_current_process = nullptr;
+    SetCurrentProcess(nullptr);
 
     Kernel::TimersShutdown();
     Kernel::ResourceLimitsShutdown();
@@ -112,6 +112,10 @@ private:
     friend void intrusive_ptr_add_ref(Object*);
     friend void intrusive_ptr_release(Object*);
 
+    /**
+     * References are only taken and dropped with HLE::g_hle_lock held. Code running without it
+     * resolves handles through HandleTable::Lookup, which doesn't touch the ref-count.
+     */
     unsigned int ref_count = 0;
     unsigned int object_id = next_object_id++;
 };
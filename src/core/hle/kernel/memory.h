@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include "common/common_types.h"
 #include "core/hle/kernel/process.h"
@@ -15,7 +16,7 @@ class VMManager;
 struct MemoryRegionInfo {
     u64 base; // Not an address, but offset from start of FCRAM
     u64 size;
-    u64 used;
+    std::atomic<u64> used; ///< Also updated by the SVCs running without HLE::g_hle_lock
 
     std::shared_ptr<std::vector<u8>> linear_heap_memory;
 };
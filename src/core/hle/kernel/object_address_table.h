@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <map>
+#include <unordered_map>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
 
@@ -54,7 +54,7 @@ public:
 
 private:
     /// Stores the Object referenced by the address
-    std::map<VAddr, SharedPtr<Object>> objects;
+    std::unordered_map<VAddr, SharedPtr<Object>> objects;
 };
 
 extern ObjectAddressTable g_object_address_table;
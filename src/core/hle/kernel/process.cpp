@@ -3,7 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include "common/assert.h"
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
@@ -180,33 +182,56 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u64 size, VMAPermission per
         return ERR_INVALID_ADDRESS;
     }
 
+    std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
+
     if (heap_memory == nullptr) {
-        // Initialize heap
+        // Initialize heap. Enough space is reserved up front for the whole heap region, so that
+        // growing the heap never relocates its backing memory and existing mappings (including
+        // those of the CPU) stay valid. Note that this is an ordinary allocation rather than an
+        // address space reservation: resizing zero-fills (and so commits) the used part, shrinking
+        // doesn't give memory back, and Windows charges commit for the whole region up front.
         heap_memory = std::make_shared<std::vector<u8>>();
-        heap_start = heap_end = target;
+        heap_memory->reserve(Memory::HEAP_SIZE);
+        heap_start = heap_end = Memory::HEAP_VADDR;
     }
 
-    // If necessary, expand backing vector to cover new heap extents.
-    if (target < heap_start) {
-        heap_memory->insert(begin(*heap_memory), heap_start - target, 0);
-        heap_start = target;
-        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
-    }
-    if (target + size > heap_end) {
-        heap_memory->insert(end(*heap_memory), (target + size) - heap_end, 0);
-        heap_end = target + size;
-        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
-    }
-    ASSERT(heap_end - heap_start == heap_memory->size());
+    const u8* const heap_data = heap_memory->data();
+    const VAddr new_heap_end = target + size;
+
+    if (heap_used != 0 && heap_end - heap_used == target) {
+        // The heap is being resized in place. Only its tail is mapped or unmapped, the unchanged
+        // part stays mapped so that other cores never see it disappear.
+        if (new_heap_end > heap_end) {
+            heap_memory->resize(new_heap_end - heap_start);
+            CASCADE_RESULT(auto vma,
+                           vm_manager.MapMemoryBlock(heap_end, heap_memory, heap_end - heap_start,
+                                                     new_heap_end - heap_end, MemoryState::Heap));
+            vm_manager.Reprotect(vma, perms);
+        } else if (new_heap_end < heap_end) {
+            vm_manager.UnmapRange(new_heap_end, heap_end - new_heap_end);
+            heap_memory->resize(new_heap_end - heap_start);
+        }
+    } else {
+        if (heap_used != 0) {
+            // The new allocation replaces the previous one.
+            vm_manager.UnmapRange(heap_start, heap_end - heap_start);
+        }
 
-    CASCADE_RESULT(auto vma, vm_manager.MapMemoryBlock(target, heap_memory, target - heap_start,
-                                                       size, MemoryState::Heap));
-    vm_manager.Reprotect(vma, perms);
+        // Resize the backing vector to cover the new heap extents. This stays within the
+        // reserved capacity, so it never moves the existing contents.
+        heap_memory->resize(new_heap_end - heap_start);
+        CASCADE_RESULT(auto vma, vm_manager.MapMemoryBlock(target, heap_memory, target - heap_start,
+                                                           size, MemoryState::Heap));
+        vm_manager.Reprotect(vma, perms);
+    }
+    ASSERT(heap_memory->data() == heap_data);
 
-    heap_used += size;
     memory_region->used += size;
+    memory_region->used -= heap_used;
+    heap_used = size;
+    heap_end = new_heap_end;
 
-    return MakeResult<VAddr>(heap_end - size);
+    return MakeResult<VAddr>(target);
 }
 
 ResultCode Process::HeapFree(VAddr target, u32 size) {
@@ -219,6 +244,7 @@ ResultCode Process::HeapFree(VAddr target, u32 size) {
         return RESULT_SUCCESS;
     }
 
+    std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
     ResultCode result = vm_manager.UnmapRange(target, size);
     if (result.IsError())
         return result;
@@ -252,6 +278,7 @@ ResultCode Process::LinearFree(VAddr target, u32 size) {
         return ERR_INVALID_ADDRESS_STATE;
     }
 
+    std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
     ResultCode result = vm_manager.UnmapRange(target, size);
     if (result.IsError())
         return result;
@@ -275,6 +302,7 @@ ResultCode Process::LinearFree(VAddr target, u32 size) {
 }
 
 ResultCode Process::MirrorMemory(VAddr dst_addr, VAddr src_addr, u64 size) {
+    std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
     auto vma = vm_manager.FindVMA(src_addr);
 
     ASSERT_MSG(vma != vm_manager.vma_map.end(), "Invalid memory address");
@@ -300,6 +328,7 @@ ResultCode Process::MirrorMemory(VAddr dst_addr, VAddr src_addr, u64 size) {
 }
 
 ResultCode Process::UnmapMemory(VAddr dst_addr, VAddr /*src_addr*/, u64 size) {
+    std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
     return vm_manager.UnmapRange(dst_addr, size);
 }
 
@@ -322,4 +351,16 @@ SharedPtr<Process> GetProcessById(u32 process_id) {
 }
 
 SharedPtr<Process> g_current_process;
+
+// Mirrors g_current_process for the readers that don't hold HLE::g_hle_lock.
+static std::atomic<Process*> current_process{nullptr};
+
+void SetCurrentProcess(SharedPtr<Process> process) {
+    current_process.store(process.get(), std::memory_order_release);
+    g_current_process = std::move(process);
+}
+
+Process* GetCurrentProcess() {
+    return current_process.load(std::memory_order_acquire);
+}
 } // namespace Kernel
@@ -158,9 +158,13 @@ public:
     // Memory used to back the allocations in the regular heap. A single vector is used to cover
     // the entire virtual address space extents that bound the allocations, including any holes.
     // This makes deallocation and reallocation of holes fast and keeps process memory contiguous
-    // in the emulator address space, allowing Memory::GetPointer to be reasonably safe.
+    // in the emulator address space, allowing Memory::GetPointer to be reasonably safe. Capacity
+    // for the whole heap region is reserved on first use, so the vector is never relocated.
+    // TODO: Back it with a host address space reservation that only commits the used part, once
+    // SharedMemory and MirrorMemory can alias memory that isn't owned by a vector.
     std::shared_ptr<std::vector<u8>> heap_memory;
-    // The left/right bounds of the address space covered by heap_memory.
+    // The left/right bounds of the address space covered by heap_memory. heap_start is always
+    // Memory::HEAP_VADDR once the heap has been initialized.
     VAddr heap_start = 0, heap_end = 0;
 
     u64 heap_used = 0, linear_heap_used = 0, misc_memory_used = 0;
@@ -200,5 +204,18 @@ void ClearProcessList();
 /// Retrieves a process from the current list of processes.
 SharedPtr<Process> GetProcessById(u32 process_id);
 
+/// The current process. Must only be accessed with HLE::g_hle_lock held.
 extern SharedPtr<Process> g_current_process;
+
+/**
+ * Makes `process` the current process. Must be called with HLE::g_hle_lock held, and used instead
+ * of assigning g_current_process directly so that GetCurrentProcess() stays in sync.
+ */
+void SetCurrentProcess(SharedPtr<Process> process);
+
+/**
+ * Returns the current process without requiring HLE::g_hle_lock, for the paths that run unlocked
+ * such as the address space SVCs. The process is kept alive by g_current_process.
+ */
+Process* GetCurrentProcess();
 } // namespace Kernel
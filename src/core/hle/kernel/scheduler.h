@@ -0,0 +1,67 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "common/thread_queue_list.h"
+#include "core/hle/kernel/thread.h"
+
+class ARM_Interface;
+
+namespace Kernel {
+
+/**
+ * Schedules the guest threads assigned to a single emulated CPU core. All the functions of this
+ * class must be called with HLE::g_hle_lock held, as other cores may schedule threads onto this
+ * one at any time.
+ */
+class Scheduler final {
+public:
+    explicit Scheduler(ARM_Interface* cpu_core);
+    ~Scheduler();
+
+    /// Returns whether there are any threads that are ready to run.
+    bool HaveReadyThreads();
+
+    /// Reschedules to the next available thread (call after current thread is suspended)
+    void Reschedule();
+
+    /// Gets the thread currently running on this core
+    Thread* GetCurrentThread() const;
+
+    /// Adds a thread that has become ready to the ready queue
+    void ScheduleThread(Thread* thread, u32 priority);
+
+    /// Removes a ready thread from the ready queue
+    void UnscheduleThread(Thread* thread, u32 priority);
+
+    /// Moves a ready thread to the queue of a new priority
+    void SetThreadPriority(Thread* thread, u32 old_priority, u32 new_priority);
+
+    /// Clears all the scheduling state, used when shutting down the kernel
+    void Clear();
+
+private:
+    /**
+     * Pops and returns the next thread from the thread queue
+     * @return A pointer to the next ready thread
+     */
+    Thread* PopNextReadyThread();
+
+    /**
+     * Switches the CPU's active thread context to that of the specified thread
+     * @param new_thread The thread to switch to
+     */
+    void SwitchContext(Thread* new_thread);
+
+    /// Lists only ready threads, linked through Thread::ready_queue_node.
+    Common::ThreadQueueList<Thread, THREADPRIO_LOWEST + 1, &Thread::ready_queue_node> ready_queue;
+
+    SharedPtr<Thread> current_thread = nullptr;
+
+    ARM_Interface* cpu_core;
+};
+
+} // namespace Kernel
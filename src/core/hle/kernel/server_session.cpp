@@ -4,6 +4,7 @@
 
 #include <tuple>
 
+#include "core/core.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/client_session.h"
 #include "core/hle/kernel/handle_table.h"
@@ -74,7 +75,10 @@ ResultCode ServerSession::HandleSyncRequest(SharedPtr<Thread> thread) {
         context.PopulateFromIncomingCommandBuffer(cmd_buf, *Kernel::g_current_process,
                                                   Kernel::g_handle_table);
 
+        const auto handle_begin = Core::PerfStats::Clock::now();
         result = hle_handler->HandleSyncRequest(context);
+        Core::System::GetInstance().perf_stats.AddSubsystemTime(
+            Core::PerfStats::Subsystem::Services, Core::PerfStats::Clock::now() - handle_begin);
     } else {
         // Add the thread to the list of threads that have issued a sync request with this
         // server.
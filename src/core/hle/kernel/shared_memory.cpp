@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <mutex>
 #include "common/logging/log.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/memory.h"
@@ -52,10 +53,13 @@ SharedPtr<SharedMemory> SharedMemory::Create(SharedPtr<Process> owner_process, u
 
         // Refresh the address mappings for the current process.
         if (Kernel::g_current_process != nullptr) {
-            Kernel::g_current_process->vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
+            auto& vm_manager = Kernel::g_current_process->vm_manager;
+            std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
+            vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
         }
     } else {
         auto& vm_manager = shared_memory->owner_process->vm_manager;
+        std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
         // The memory is already available and mapped in the owner process.
         auto vma = vm_manager.FindVMA(address);
         ASSERT_MSG(vma != vm_manager.vma_map.end(), "Invalid memory address");
@@ -151,6 +155,7 @@ ResultCode SharedMemory::Map(Process* target_process, VAddr address, MemoryPermi
     }
 
     // Map the memory block into the target process
+    std::lock_guard<HLE::ProfiledMutex> lock(target_process->vm_manager.mutex);
     auto result = target_process->vm_manager.MapMemoryBlock(
         target_address, backing_block, backing_block_offset, size, MemoryState::Shared);
     if (result.Failed()) {
@@ -168,6 +173,7 @@ ResultCode SharedMemory::Map(Process* target_process, VAddr address, MemoryPermi
 ResultCode SharedMemory::Unmap(Process* target_process, VAddr address) {
     // TODO(Subv): Verify what happens if the application tries to unmap an address that is not
     // mapped to a SharedMemory.
+    std::lock_guard<HLE::ProfiledMutex> lock(target_process->vm_manager.mutex);
     return target_process->vm_manager.UnmapRange(address, size);
 }
 
@@ -3,6 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <limits>
+#include <mutex>
 
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -17,6 +21,7 @@
 #include "core/hle/kernel/object_address_table.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
+#include "core/hle/kernel/scheduler.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/kernel/svc.h"
 #include "core/hle/kernel/svc_wrap.h"
@@ -31,7 +36,7 @@ namespace Kernel {
 /// Set the process heap to a given Size. It can both extend and shrink the heap.
 static ResultCode SetHeapSize(VAddr* heap_addr, u64 heap_size) {
     LOG_TRACE(Kernel_SVC, "called, heap_size=0x%llx", heap_size);
-    auto& process = *g_current_process;
+    auto& process = *GetCurrentProcess();
     CASCADE_RESULT(*heap_addr,
                    process.HeapAllocate(Memory::HEAP_VADDR, heap_size, VMAPermission::ReadWrite));
     return RESULT_SUCCESS;
@@ -46,14 +51,14 @@ static ResultCode SetMemoryAttribute(VAddr addr, u64 size, u32 state0, u32 state
 static ResultCode MapMemory(VAddr dst_addr, VAddr src_addr, u64 size) {
     LOG_TRACE(Kernel_SVC, "called, dst_addr=0x%llx, src_addr=0x%llx, size=0x%llx", dst_addr,
               src_addr, size);
-    return g_current_process->MirrorMemory(dst_addr, src_addr, size);
+    return GetCurrentProcess()->MirrorMemory(dst_addr, src_addr, size);
 }
 
 /// Unmaps a region that was previously mapped with svcMapMemory
 static ResultCode UnmapMemory(VAddr dst_addr, VAddr src_addr, u64 size) {
     LOG_TRACE(Kernel_SVC, "called, dst_addr=0x%llx, src_addr=0x%llx, size=0x%llx", dst_addr,
               src_addr, size);
-    return g_current_process->UnmapMemory(dst_addr, src_addr, size);
+    return GetCurrentProcess()->UnmapMemory(dst_addr, src_addr, size);
 }
 
 /// Connect to an OS service given the port name, returns the handle to the port to out
@@ -106,7 +111,8 @@ static ResultCode SendSyncRequest(Handle handle) {
 static ResultCode GetThreadId(u32* thread_id, Handle thread_handle) {
     LOG_TRACE(Kernel_SVC, "called thread=0x%08X", thread_handle);
 
-    const SharedPtr<Thread> thread = g_handle_table.Get<Thread>(thread_handle);
+    HandleTable::ReadGuard guard(g_handle_table);
+    const Thread* thread = g_handle_table.Lookup<Thread>(thread_handle);
     if (!thread) {
         return ERR_INVALID_HANDLE;
     }
@@ -119,7 +125,8 @@ static ResultCode GetThreadId(u32* thread_id, Handle thread_handle) {
 static ResultCode GetProcessId(u32* process_id, Handle process_handle) {
     LOG_TRACE(Kernel_SVC, "called process=0x%08X", process_handle);
 
-    const SharedPtr<Process> process = g_handle_table.Get<Process>(process_handle);
+    HandleTable::ReadGuard guard(g_handle_table);
+    const Process* process = g_handle_table.Lookup<Process>(process_handle);
     if (!process) {
         return ERR_INVALID_HANDLE;
     }
@@ -306,11 +313,13 @@ static ResultCode GetInfo(u64* result, u64 info_id, u64 handle, u64 info_sub_id)
 
     ASSERT(handle == 0 || handle == CurrentProcess);
 
-    auto& vm_manager = g_current_process->vm_manager;
+    Process* const process = GetCurrentProcess();
+    auto& vm_manager = process->vm_manager;
+    std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
 
     switch (static_cast<GetInfoType>(info_id)) {
     case GetInfoType::AllowedCpuIdBitmask:
-        *result = g_current_process->allowed_processor_mask;
+        *result = process->allowed_processor_mask;
         break;
     case GetInfoType::TotalMemoryUsage:
         *result = vm_manager.GetTotalMemoryUsage();
@@ -380,8 +389,51 @@ static ResultCode SetThreadPriority(Handle handle, u32 priority) {
 
 /// Get which CPU core is executing the current thread
 static u32 GetCurrentProcessorNumber() {
-    LOG_WARNING(Kernel_SVC, "(STUBBED) called, defaulting to processor 0");
-    return 0;
+    LOG_TRACE(Kernel_SVC, "called");
+    return static_cast<u32>(Core::System::GetInstance().CurrentCpuCore().CoreIndex());
+}
+
+/// Gets the ideal core and the allowed cores of the specified thread
+static ResultCode GetThreadCoreMask(u32* core, u64* mask, Handle thread_handle) {
+    LOG_TRACE(Kernel_SVC, "called, handle=0x%08X", thread_handle);
+
+    const SharedPtr<Thread> thread = g_handle_table.Get<Thread>(thread_handle);
+    if (!thread) {
+        return ERR_INVALID_HANDLE;
+    }
+
+    *core = thread->ideal_core;
+    *mask = thread->affinity_mask;
+    return RESULT_SUCCESS;
+}
+
+/// Sets the ideal core and the allowed cores of the specified thread
+static ResultCode SetThreadCoreMask(Handle thread_handle, u32 core, u64 mask) {
+    LOG_TRACE(Kernel_SVC, "called, handle=0x%08X, core=0x%X, mask=0x%016" PRIX64, thread_handle,
+              core, mask);
+
+    const SharedPtr<Thread> thread = g_handle_table.Get<Thread>(thread_handle);
+    if (!thread) {
+        return ERR_INVALID_HANDLE;
+    }
+
+    if (static_cast<s32>(core) == THREADPROCESSORID_DEFAULT) {
+        // Use the ideal core and allowed cores specified in the process' exheader
+        core = g_current_process->ideal_processor;
+        mask = g_current_process->allowed_processor_mask;
+    }
+
+    if (mask == 0 || (mask & ~static_cast<u64>(THREADPROCESSORID_DEFAULT_MASK)) != 0) {
+        return ERR_OUT_OF_RANGE_KERNEL;
+    }
+
+    if (core >= THREADPROCESSORID_MAX || ((mask >> core) & 1) == 0) {
+        return ERR_INVALID_COMBINATION;
+    }
+
+    thread->ChangeCore(core, mask);
+    Core::System::GetInstance().PrepareReschedule();
+    return RESULT_SUCCESS;
 }
 
 static ResultCode MapSharedMemory(Handle shared_memory_handle, VAddr addr, u64 size,
@@ -418,13 +470,22 @@ static ResultCode MapSharedMemory(Handle shared_memory_handle, VAddr addr, u64 s
 /// Query process memory
 static ResultCode QueryProcessMemory(MemoryInfo* memory_info, PageInfo* /*page_info*/,
                                      Handle process_handle, u64 addr) {
-    SharedPtr<Process> process = g_handle_table.Get<Process>(process_handle);
+    // The current process is resolved without HLE::g_hle_lock, which QueryMemory doesn't hold.
+    // Other processes are taken under it rather than with a ReadGuard, as the guard may hold the
+    // handle table mutex, which must not be kept while acquiring the address space mutex.
+    Process* process = GetCurrentProcess();
+    SharedPtr<Process> other_process;
+    if (process_handle != CurrentProcess) {
+        other_process = g_handle_table.Get<Process>(process_handle);
+        process = other_process.get();
+    }
     if (!process) {
         return ERR_INVALID_HANDLE;
     }
+    std::lock_guard<HLE::ProfiledMutex> lock(process->vm_manager.mutex);
     auto vma = process->vm_manager.FindVMA(addr);
     memory_info->attributes = 0;
-    if (vma == g_current_process->vm_manager.vma_map.end()) {
+    if (vma == process->vm_manager.vma_map.end()) {
         memory_info->base_address = 0;
         memory_info->permission = static_cast<u32>(VMAPermission::None);
         memory_info->size = 0;
@@ -497,22 +558,6 @@ static ResultCode CreateThread(Handle* out_handle, VAddr entry_point, u64 arg, V
         ASSERT(processor_id != THREADPROCESSORID_DEFAULT);
     }
 
-    switch (processor_id) {
-    case THREADPROCESSORID_0:
-        break;
-    case THREADPROCESSORID_1:
-    case THREADPROCESSORID_2:
-    case THREADPROCESSORID_3:
-        // TODO(bunnei): Implement support for other processor IDs
-        LOG_ERROR(Kernel_SVC,
-                  "Newly created thread must run in another thread (%u), unimplemented.",
-                  processor_id);
-        break;
-    default:
-        ASSERT_MSG(false, "Unsupported thread processor ID: %d", processor_id);
-        break;
-    }
-
     CASCADE_RESULT(SharedPtr<Thread> thread,
                    Thread::Create(name, entry_point, priority, arg, processor_id, stack_top,
                                   g_current_process));
@@ -556,7 +601,7 @@ static void SleepThread(s64 nanoseconds) {
 
     // Don't attempt to yield execution if there are no available threads to run,
     // this way we avoid a useless reschedule to the idle thread.
-    if (nanoseconds == 0 && !HaveReadyThreads())
+    if (nanoseconds == 0 && !Core::System::GetInstance().CurrentScheduler().HaveReadyThreads())
         return;
 
     // Sleep current thread and check for next thread to schedule
@@ -674,6 +719,51 @@ static ResultCode SignalProcessWideKey(VAddr condition_variable_addr, s32 target
     return RESULT_SUCCESS;
 }
 
+namespace {
+/**
+ * Spots threads busy-waiting on the system tick: a thread which keeps calling GetSystemTick, with
+ * no other SVC and only a few instructions in between, is only waiting for time to pass. The
+ * instructions are measured with the ticks the CPU core has executed, as CoreTiming only advances
+ * once the core's time slice ends.
+ */
+struct TickPollDetector {
+    /// Number of polls in a row after which the thread is considered to be busy-waiting
+    static constexpr u32 POLL_THRESHOLD = 8;
+    /// Most ticks that may be executed between two polls of the same busy-wait loop
+    static constexpr u64 MAX_POLL_INTERVAL = 2000;
+
+    /**
+     * Records a GetSystemTick call, returns whether the caller is busy-waiting
+     * @param ticks Number of ticks executed by the calling core so far
+     */
+    bool Poll(const Thread* thread, u64 ticks) {
+        if (thread != last_thread || ticks - last_ticks > MAX_POLL_INTERVAL) {
+            last_thread = thread;
+            poll_count = 0;
+        }
+        last_ticks = ticks;
+        return ++poll_count >= POLL_THRESHOLD;
+    }
+
+    /// Forgets the polls seen so far, as the thread did something else than polling
+    void Reset() {
+        last_thread = nullptr;
+        poll_count = 0;
+    }
+
+    const Thread* last_thread = nullptr;
+    u64 last_ticks = 0;
+    u32 poll_count = 0;
+};
+} // Anonymous namespace
+
+/// Busy-wait detector of each CPU core, only used by the host thread of its core
+static std::array<TickPollDetector, Core::NUM_CPU_CORES> tick_poll_detectors;
+
+static TickPollDetector& GetTickPollDetector() {
+    return tick_poll_detectors[Core::System::GetInstance().CurrentCpuCore().CoreIndex()];
+}
+
 /// This returns the total CPU ticks elapsed since the CPU was powered-on
 static u64 GetSystemTick() {
     const u64 result{CoreTiming::GetTicks()};
@@ -681,6 +771,28 @@ static u64 GetSystemTick() {
     // Advance time to defeat dumb games that busy-wait for the frame to end.
     CoreTiming::AddTicks(400);
 
+    // Without knowing how much ran between two polls, a busy-wait can't be told apart from a
+    // thread timing its own work
+    auto& system = Core::System::GetInstance();
+    auto& cpu = system.CurrentCpuCore();
+    const auto& arm_interface = cpu.ArmInterface();
+    const auto ticks_in_run = arm_interface.GetTicksExecutedInRun();
+    if (!ticks_in_run) {
+        return result;
+    }
+
+    // Nothing can change what a busy-waiting thread sees before the next event, so skip straight
+    // to it. Only the main core drives CoreTiming.
+    auto& detector = GetTickPollDetector();
+    const u64 ticks_executed = arm_interface.GetNumInstructions() + *ticks_in_run;
+    if (detector.Poll(GetCurrentThread(), ticks_executed) && cpu.IsMainCore()) {
+        const u64 skipped_cycles = cpu.SkipToNextEvent();
+        if (skipped_cycles > 0) {
+            system.perf_stats.AddIdleSkip(skipped_cycles);
+        }
+        detector.Reset();
+    }
+
     return result;
 }
 
@@ -699,32 +811,103 @@ static ResultCode ResetSignal(Handle handle) {
     return RESULT_SUCCESS;
 }
 
-/// Creates a TransferMemory object
+/// Creates a transfer memory object, which lends a range of the process memory to other processes
 static ResultCode CreateTransferMemory(Handle* handle, VAddr addr, u64 size, u32 permissions) {
-    LOG_WARNING(Kernel_SVC, "(STUBBED) called addr=0x%llx, size=0x%llx, perms=%08X", addr, size,
-                permissions);
-    *handle = 0;
+    LOG_TRACE(Kernel_SVC, "called addr=0x%llx, size=0x%llx, perms=%08X", addr, size, permissions);
+
+    if ((addr & Memory::PAGE_MASK) != 0 || (size & Memory::PAGE_MASK) != 0) {
+        return ERR_INVALID_ADDRESS;
+    }
+    if (size == 0 || size > std::numeric_limits<u32>::max()) {
+        return ERR_INVALID_SIZE;
+    }
+
+    const auto permissions_type = static_cast<MemoryPermission>(permissions);
+    if (permissions_type != MemoryPermission::None && permissions_type != MemoryPermission::Read &&
+        permissions_type != MemoryPermission::ReadWrite) {
+        return ERR_INVALID_COMBINATION;
+    }
+
+    {
+        // The transfer memory aliases the block backing the range, so it must all be in one block
+        auto& vm_manager = g_current_process->vm_manager;
+        std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
+        const auto vma = vm_manager.FindVMA(addr);
+        if (vma == vm_manager.vma_map.end() || !vma->second.backing_block ||
+            addr + size > vma->second.base + vma->second.size) {
+            return ERR_INVALID_ADDRESS_STATE;
+        }
+    }
+
+    // The owner keeps its own permissions on the range: the console changes them to `permissions`
+    // until the handle is closed, but nothing restores them on close here yet.
+    auto transfer_memory =
+        SharedMemory::Create(g_current_process, static_cast<u32>(size), permissions_type,
+                             MemoryPermission::ReadWrite, addr, MemoryRegion::BASE,
+                             "TransferMemory");
+    CASCADE_RESULT(*handle, g_handle_table.Create(std::move(transfer_memory)));
     return RESULT_SUCCESS;
 }
 
+/// Maps a transfer memory object created by another process into the current process
+static ResultCode MapTransferMemory(Handle handle, VAddr addr, u64 size, u32 permissions) {
+    LOG_TRACE(Kernel_SVC, "called handle=0x%08X, addr=0x%llx, size=0x%llx, perms=%08X", handle,
+              addr, size, permissions);
+
+    SharedPtr<SharedMemory> transfer_memory = g_handle_table.Get<SharedMemory>(handle);
+    if (!transfer_memory) {
+        return ERR_INVALID_HANDLE;
+    }
+    if (size != transfer_memory->size) {
+        return ERR_INVALID_SIZE;
+    }
+
+    return transfer_memory->Map(g_current_process.get(), addr,
+                                static_cast<MemoryPermission>(permissions),
+                                transfer_memory->permissions);
+}
+
+/// Unmaps a transfer memory object mapped with svcMapTransferMemory
+static ResultCode UnmapTransferMemory(Handle handle, VAddr addr, u64 size) {
+    LOG_TRACE(Kernel_SVC, "called handle=0x%08X, addr=0x%llx, size=0x%llx", handle, addr, size);
+
+    SharedPtr<SharedMemory> transfer_memory = g_handle_table.Get<SharedMemory>(handle);
+    if (!transfer_memory) {
+        return ERR_INVALID_HANDLE;
+    }
+    if (size != transfer_memory->size) {
+        return ERR_INVALID_SIZE;
+    }
+
+    return transfer_memory->Unmap(g_current_process.get(), addr);
+}
+
 namespace {
+/// Lock an SVC runs under, see core/hle/lock.h for the lock order
+enum class SvcLock {
+    Kernel,       ///< HLE::g_hle_lock is held for the whole SVC
+    AddressSpace, ///< The SVC only locks the VMManager of the process it works with
+    None,         ///< The SVC only reads immutable state of objects found with HandleTable::Lookup
+};
+
 struct FunctionDef {
     using Func = void();
 
     u32 id;
     Func* func;
     const char* name;
+    SvcLock lock = SvcLock::Kernel;
 };
 } // namespace
 
 static const FunctionDef SVC_Table[] = {
     {0x00, nullptr, "Unknown"},
-    {0x01, SvcWrap<SetHeapSize>, "SetHeapSize"},
+    {0x01, SvcWrap<SetHeapSize>, "SetHeapSize", SvcLock::AddressSpace},
     {0x02, nullptr, "SetMemoryPermission"},
-    {0x03, SvcWrap<SetMemoryAttribute>, "SetMemoryAttribute"},
-    {0x04, SvcWrap<MapMemory>, "MapMemory"},
-    {0x05, SvcWrap<UnmapMemory>, "UnmapMemory"},
-    {0x06, SvcWrap<QueryMemory>, "QueryMemory"},
+    {0x03, SvcWrap<SetMemoryAttribute>, "SetMemoryAttribute", SvcLock::AddressSpace},
+    {0x04, SvcWrap<MapMemory>, "MapMemory", SvcLock::AddressSpace},
+    {0x05, SvcWrap<UnmapMemory>, "UnmapMemory", SvcLock::AddressSpace},
+    {0x06, SvcWrap<QueryMemory>, "QueryMemory", SvcLock::AddressSpace},
     {0x07, SvcWrap<ExitProcess>, "ExitProcess"},
     {0x08, SvcWrap<CreateThread>, "CreateThread"},
     {0x09, SvcWrap<StartThread>, "StartThread"},
@@ -732,8 +915,8 @@ static const FunctionDef SVC_Table[] = {
     {0x0B, SvcWrap<SleepThread>, "SleepThread"},
     {0x0C, SvcWrap<GetThreadPriority>, "GetThreadPriority"},
     {0x0D, SvcWrap<SetThreadPriority>, "SetThreadPriority"},
-    {0x0E, nullptr, "GetThreadCoreMask"},
-    {0x0F, nullptr, "SetThreadCoreMask"},
+    {0x0E, SvcWrap<GetThreadCoreMask>, "GetThreadCoreMask"},
+    {0x0F, SvcWrap<SetThreadCoreMask>, "SetThreadCoreMask"},
     {0x10, SvcWrap<GetCurrentProcessorNumber>, "GetCurrentProcessorNumber"},
     {0x11, nullptr, "SignalEvent"},
     {0x12, nullptr, "ClearEvent"},
@@ -754,12 +937,12 @@ static const FunctionDef SVC_Table[] = {
     {0x21, SvcWrap<SendSyncRequest>, "SendSyncRequest"},
     {0x22, nullptr, "SendSyncRequestWithUserBuffer"},
     {0x23, nullptr, "SendAsyncRequestWithUserBuffer"},
-    {0x24, SvcWrap<GetProcessId>, "GetProcessId"},
-    {0x25, SvcWrap<GetThreadId>, "GetThreadId"},
+    {0x24, SvcWrap<GetProcessId>, "GetProcessId", SvcLock::None},
+    {0x25, SvcWrap<GetThreadId>, "GetThreadId", SvcLock::None},
     {0x26, SvcWrap<Break>, "Break"},
-    {0x27, SvcWrap<OutputDebugString>, "OutputDebugString"},
+    {0x27, SvcWrap<OutputDebugString>, "OutputDebugString", SvcLock::AddressSpace},
     {0x28, nullptr, "ReturnFromException"},
-    {0x29, SvcWrap<GetInfo>, "GetInfo"},
+    {0x29, SvcWrap<GetInfo>, "GetInfo", SvcLock::AddressSpace},
     {0x2A, nullptr, "FlushEntireDataCache"},
     {0x2B, nullptr, "FlushDataCache"},
     {0x2C, nullptr, "MapPhysicalMemory"},
@@ -799,8 +982,8 @@ static const FunctionDef SVC_Table[] = {
     {0x4E, nullptr, "ReadWriteRegister"},
     {0x4F, nullptr, "SetProcessActivity"},
     {0x50, nullptr, "CreateSharedMemory"},
-    {0x51, nullptr, "MapTransferMemory"},
-    {0x52, nullptr, "UnmapTransferMemory"},
+    {0x51, SvcWrap<MapTransferMemory>, "MapTransferMemory"},
+    {0x52, SvcWrap<UnmapTransferMemory>, "UnmapTransferMemory"},
     {0x53, nullptr, "CreateInterruptEvent"},
     {0x54, nullptr, "QueryPhysicalAddress"},
     {0x55, nullptr, "QueryIoMapping"},
@@ -861,12 +1044,21 @@ MICROPROFILE_DEFINE(Kernel_SVC, "Kernel", "SVC", MP_RGB(70, 200, 70));
 void CallSVC(u32 immediate) {
     MICROPROFILE_SCOPE(Kernel_SVC);
 
-    // Lock the global kernel mutex when we enter the kernel HLE.
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
-
     const FunctionDef* info = GetSVCInfo(immediate);
     if (info) {
         if (info->func) {
+            // Any other SVC means the thread is doing more than polling the system tick
+            if (info->func != SvcWrap<GetSystemTick>) {
+                GetTickPollDetector().Reset();
+            }
+
+            if (info->lock != SvcLock::Kernel) {
+                info->func();
+                return;
+            }
+
+            // Lock the global kernel mutex when we enter the kernel HLE.
+            std::lock_guard<HLE::ProfiledMutex> lock(HLE::g_hle_lock);
             info->func();
         } else {
             LOG_CRITICAL(Kernel_SVC, "unimplemented SVC function %s(..)", info->name);
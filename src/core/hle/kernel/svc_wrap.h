@@ -57,6 +57,21 @@ void SvcWrap() {
     FuncReturn(retval);
 }
 
+template <ResultCode func(u32*, u64*, u32)>
+void SvcWrap() {
+    u32 param_1 = 0;
+    u64 param_2 = 0;
+    u32 retval = func(&param_1, &param_2, (u32)PARAM(2)).raw;
+    Core::CPU().SetReg(1, param_1);
+    Core::CPU().SetReg(2, param_2);
+    FuncReturn(retval);
+}
+
+template <ResultCode func(u32, u32, u64)>
+void SvcWrap() {
+    FuncReturn(func((u32)PARAM(0), (u32)PARAM(1), PARAM(2)).raw);
+}
+
 template <ResultCode func(u64, s32)>
 void SvcWrap() {
     FuncReturn(func(PARAM(0), (s32)PARAM(1)).raw);
@@ -86,6 +101,11 @@ void SvcWrap() {
     FuncReturn(func(PARAM(0), PARAM(1), PARAM(2)).raw);
 }
 
+template <ResultCode func(u32, u64, u64)>
+void SvcWrap() {
+    FuncReturn(func((u32)PARAM(0), PARAM(1), PARAM(2)).raw);
+}
+
 template <ResultCode func(u32, u64, u64, u32)>
 void SvcWrap() {
     FuncReturn(func((u32)PARAM(0), PARAM(1), PARAM(2), (u32)PARAM(3)).raw);
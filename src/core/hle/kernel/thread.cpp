@@ -4,12 +4,12 @@
 
 #include <algorithm>
 #include <list>
+#include <mutex>
 #include <vector>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
-#include "common/thread_queue_list.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -19,6 +19,7 @@
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/kernel/scheduler.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 #include "core/memory.h"
@@ -43,10 +44,10 @@ static Kernel::HandleTable wakeup_callback_handle_table;
 // Lists all thread ids that aren't deleted/etc.
 static std::vector<SharedPtr<Thread>> thread_list;
 
-// Lists only ready thread ids.
-static Common::ThreadQueueList<Thread*, THREADPRIO_LOWEST + 1> ready_queue;
-
-static SharedPtr<Thread> current_thread;
+// Threads waiting on an address arbiter, indexed by their arbitration address. No SVC creates
+// address arbiters yet, so nothing waits here until one does.
+static Common::KeyedThreadQueueList<VAddr, Thread, THREADPRIO_LOWEST + 1, &Thread::arbitration_node>
+    arbitration_queue;
 
 // The first available thread id at startup
 static u32 next_thread_id;
@@ -63,29 +64,21 @@ Thread::Thread() {}
 Thread::~Thread() {}
 
 Thread* GetCurrentThread() {
-    return current_thread.get();
-}
-
-/**
- * Check if the specified thread is waiting on the specified address to be arbitrated
- * @param thread The thread to test
- * @param wait_address The address to test against
- * @return True if the thread is waiting, false otherwise
- */
-static bool CheckWait_AddressArbiter(const Thread* thread, VAddr wait_address) {
-    return thread->status == THREADSTATUS_WAIT_ARB && wait_address == thread->wait_address;
+    return Core::System::GetInstance().CurrentScheduler().GetCurrentThread();
 }
 
 void Thread::Stop() {
     // Cancel any outstanding wakeup events for this thread
-    CoreTiming::UnscheduleEvent(ThreadWakeupEventType, callback_handle);
+    CancelWakeupTimer();
     wakeup_callback_handle_table.Close(callback_handle);
     callback_handle = 0;
 
     // Clean up thread from ready queue
     // This is only needed when the thread is termintated forcefully (SVC TerminateProcess)
     if (status == THREADSTATUS_READY) {
-        ready_queue.remove(current_priority, this);
+        scheduler->UnscheduleThread(this, current_priority);
+    } else if (status == THREADSTATUS_WAIT_ARB) {
+        arbitration_queue.remove(wait_address, current_priority, this);
     }
 
     status = THREADSTATUS_DEAD;
@@ -108,23 +101,9 @@ void Thread::Stop() {
     Kernel::g_current_process->tls_slots[tls_page].reset(tls_slot);
 }
 
-Thread* ArbitrateHighestPriorityThread(u32 address) {
-    Thread* highest_priority_thread = nullptr;
-    u32 priority = THREADPRIO_LOWEST;
-
-    // Iterate through threads, find highest priority thread that is waiting to be arbitrated...
-    for (auto& thread : thread_list) {
-        if (!CheckWait_AddressArbiter(thread.get(), address))
-            continue;
-
-        if (thread == nullptr)
-            continue;
-
-        if (thread->current_priority <= priority) {
-            highest_priority_thread = thread.get();
-            priority = thread->current_priority;
-        }
-    }
+Thread* ArbitrateHighestPriorityThread(VAddr address) {
+    // Threads of the same priority are arbitrated in the order they started waiting
+    Thread* highest_priority_thread = arbitration_queue.pop_first(address);
 
     // If a thread was arbitrated, resume it
     if (nullptr != highest_priority_thread) {
@@ -134,84 +113,11 @@ Thread* ArbitrateHighestPriorityThread(u32 address) {
     return highest_priority_thread;
 }
 
-void ArbitrateAllThreads(u32 address) {
+void ArbitrateAllThreads(VAddr address) {
     // Resume all threads found to be waiting on the address
-    for (auto& thread : thread_list) {
-        if (CheckWait_AddressArbiter(thread.get(), address))
-            thread->ResumeFromWait();
-    }
-}
-
-/**
- * Switches the CPU's active thread context to that of the specified thread
- * @param new_thread The thread to switch to
- */
-static void SwitchContext(Thread* new_thread) {
-    Thread* previous_thread = GetCurrentThread();
-
-    // Save context for previous thread
-    if (previous_thread) {
-        previous_thread->last_running_ticks = CoreTiming::GetTicks();
-        Core::CPU().SaveContext(previous_thread->context);
-
-        if (previous_thread->status == THREADSTATUS_RUNNING) {
-            // This is only the case when a reschedule is triggered without the current thread
-            // yielding execution (i.e. an event triggered, system core time-sliced, etc)
-            ready_queue.push_front(previous_thread->current_priority, previous_thread);
-            previous_thread->status = THREADSTATUS_READY;
-        }
-    }
-
-    // Load context of new thread
-    if (new_thread) {
-        ASSERT_MSG(new_thread->status == THREADSTATUS_READY,
-                   "Thread must be ready to become running.");
-
-        // Cancel any outstanding wakeup events for this thread
-        CoreTiming::UnscheduleEvent(ThreadWakeupEventType, new_thread->callback_handle);
-
-        auto previous_process = Kernel::g_current_process;
-
-        current_thread = new_thread;
-
-        ready_queue.remove(new_thread->current_priority, new_thread);
-        new_thread->status = THREADSTATUS_RUNNING;
-
-        if (previous_process != current_thread->owner_process) {
-            Kernel::g_current_process = current_thread->owner_process;
-            SetCurrentPageTable(&Kernel::g_current_process->vm_manager.page_table);
-        }
-
-        Core::CPU().LoadContext(new_thread->context);
-        Core::CPU().SetTlsAddress(new_thread->GetTLSAddress());
-    } else {
-        current_thread = nullptr;
-        // Note: We do not reset the current process and current page table when idling because
-        // technically we haven't changed processes, our threads are just paused.
-    }
-}
-
-/**
- * Pops and returns the next thread from the thread queue
- * @return A pointer to the next ready thread
- */
-static Thread* PopNextReadyThread() {
-    Thread* next;
-    Thread* thread = GetCurrentThread();
-
-    if (thread && thread->status == THREADSTATUS_RUNNING) {
-        // We have to do better than the current thread.
-        // This call returns null when that's not possible.
-        next = ready_queue.pop_first_better(thread->current_priority);
-        if (!next) {
-            // Otherwise just keep going with the current thread
-            next = thread;
-        }
-    } else {
-        next = ready_queue.pop_first();
+    while (Thread* thread = arbitration_queue.pop_first(address)) {
+        thread->ResumeFromWait();
     }
-
-    return next;
 }
 
 void WaitCurrentThread_Sleep() {
@@ -223,6 +129,7 @@ void WaitCurrentThread_ArbitrateAddress(VAddr wait_address) {
     Thread* thread = GetCurrentThread();
     thread->wait_address = wait_address;
     thread->status = THREADSTATUS_WAIT_ARB;
+    arbitration_queue.push_back(wait_address, thread->current_priority, thread);
 }
 
 void ExitCurrentThread() {
@@ -268,20 +175,51 @@ void Thread::WakeAfterDelay(s64 nanoseconds) {
     if (nanoseconds == -1)
         return;
 
-    CoreTiming::ScheduleEvent(nsToCycles(nanoseconds), ThreadWakeupEventType, callback_handle);
+    wakeup_event =
+        CoreTiming::ScheduleEvent(nsToCycles(nanoseconds), ThreadWakeupEventType, callback_handle);
 }
 
 void Thread::CancelWakeupTimer() {
-    CoreTiming::UnscheduleEvent(ThreadWakeupEventType, callback_handle);
+    CoreTiming::UnscheduleEvent(wakeup_event);
+    wakeup_event = CoreTiming::INVALID_EVENT_HANDLE;
+}
+
+/**
+ * Selects the core a thread should be scheduled on. The thread stays on the core it last ran on if
+ * it is still allowed there, otherwise it moves to its ideal core, or failing that to the first
+ * core it is allowed on.
+ * @param current_core The core the thread last ran on
+ * @param ideal_core The core the thread prefers to be run on
+ * @param affinity_mask Bitmask of the cores the thread is allowed to be run on
+ * @return The index of the selected core
+ */
+static s32 SelectCore(s32 current_core, s32 ideal_core, u64 affinity_mask) {
+    if ((affinity_mask >> current_core) & 1) {
+        return current_core;
+    }
+    if ((affinity_mask >> ideal_core) & 1) {
+        return ideal_core;
+    }
+    for (s32 core = 0; core < THREADPROCESSORID_MAX; ++core) {
+        if ((affinity_mask >> core) & 1) {
+            return core;
+        }
+    }
+    UNREACHABLE_MSG("Thread has no core it is allowed to run on");
+    return current_core;
 }
 
 void Thread::ResumeFromWait() {
     ASSERT_MSG(wait_objects.empty(), "Thread is waking up while waiting for objects");
 
     switch (status) {
+    case THREADSTATUS_WAIT_ARB:
+        // Only needed when the wait timed out, arbitrated threads have already been dequeued
+        arbitration_queue.remove(wait_address, current_priority, this);
+        break;
+
     case THREADSTATUS_WAIT_SYNCH_ALL:
     case THREADSTATUS_WAIT_SYNCH_ANY:
-    case THREADSTATUS_WAIT_ARB:
     case THREADSTATUS_WAIT_SLEEP:
         break;
 
@@ -306,29 +244,39 @@ void Thread::ResumeFromWait() {
 
     wakeup_callback = nullptr;
 
-    ready_queue.push_back(current_priority, this);
+    // A thread which is still the current thread of its core only has its context saved once
+    // that core reschedules, so it can't be picked up by another core before then. It stays on
+    // its core for now and migrates the next time it is woken up.
+    if (scheduler->GetCurrentThread() != this) {
+        const s32 new_processor_id = SelectCore(processor_id, ideal_core, affinity_mask);
+        if (new_processor_id != processor_id) {
+            processor_id = new_processor_id;
+            scheduler = Core::System::GetInstance().Scheduler(processor_id);
+        }
+    }
+
+    scheduler->ScheduleThread(this, current_priority);
     status = THREADSTATUS_READY;
-    Core::System::GetInstance().PrepareReschedule();
+    Core::System::GetInstance().CpuCore(processor_id).PrepareReschedule();
 }
 
-/**
- * Prints the thread queue for debugging purposes
- */
-static void DebugThreadQueue() {
-    Thread* thread = GetCurrentThread();
-    if (!thread) {
-        LOG_DEBUG(Kernel, "Current: NO CURRENT THREAD");
-    } else {
-        LOG_DEBUG(Kernel, "0x%02X %u (current)", thread->current_priority,
-                  GetCurrentThread()->GetObjectId());
-    }
+void Thread::ChangeCore(u32 core, u64 mask) {
+    ideal_core = core;
+    affinity_mask = mask;
 
-    for (auto& t : thread_list) {
-        u32 priority = ready_queue.contains(t.get());
-        if (priority != -1) {
-            LOG_DEBUG(Kernel, "0x%02X %u", priority, t->GetObjectId());
-        }
+    if (status != THREADSTATUS_READY || ((affinity_mask >> processor_id) & 1) ||
+        scheduler->GetCurrentThread() == this) {
+        // The thread migrates the next time it is woken up, a running thread has to give up its
+        // core before it can be moved.
+        return;
     }
+
+    // Move a ready thread to the ready queue of its new core straight away
+    scheduler->UnscheduleThread(this, current_priority);
+    processor_id = SelectCore(processor_id, ideal_core, affinity_mask);
+    scheduler = Core::System::GetInstance().Scheduler(processor_id);
+    scheduler->ScheduleThread(this, current_priority);
+    Core::System::GetInstance().CpuCore(processor_id).PrepareReschedule();
 }
 
 /**
@@ -383,7 +331,7 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
         return ERR_OUT_OF_RANGE;
     }
 
-    if (processor_id > THREADPROCESSORID_MAX) {
+    if (processor_id < 0 || processor_id >= THREADPROCESSORID_MAX) {
         LOG_ERROR(Kernel_SVC, "Invalid processor id: %d", processor_id);
         return ERR_OUT_OF_RANGE_KERNEL;
     }
@@ -399,7 +347,6 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     SharedPtr<Thread> thread(new Thread);
 
     thread_list.push_back(thread);
-    ready_queue.prepare(priority);
 
     thread->thread_id = NewThreadId();
     thread->status = THREADSTATUS_DORMANT;
@@ -408,6 +355,9 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     thread->nominal_priority = thread->current_priority = priority;
     thread->last_running_ticks = CoreTiming::GetTicks();
     thread->processor_id = processor_id;
+    thread->ideal_core = processor_id;
+    thread->affinity_mask = 1ULL << processor_id;
+    thread->scheduler = Core::System::GetInstance().Scheduler(processor_id);
     thread->wait_objects.clear();
     thread->wait_address = 0;
     thread->name = std::move(name);
@@ -446,6 +396,7 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
         available_slot = 0; // Use the first slot in the new page
 
         auto& vm_manager = owner_process->vm_manager;
+        std::lock_guard<HLE::ProfiledMutex> lock(vm_manager.mutex);
         vm_manager.RefreshMemoryBlockMappings(linheap_memory.get());
 
         // Map the page to the current process' address space.
@@ -472,9 +423,9 @@ void Thread::SetPriority(u32 priority) {
                "Invalid priority value.");
     // If thread was ready, adjust queues
     if (status == THREADSTATUS_READY)
-        ready_queue.move(this, current_priority, priority);
-    else
-        ready_queue.prepare(priority);
+        scheduler->SetThreadPriority(this, current_priority, priority);
+    else if (status == THREADSTATUS_WAIT_ARB)
+        arbitration_queue.move(wait_address, this, current_priority, priority);
 
     nominal_priority = current_priority = priority;
 }
@@ -491,15 +442,16 @@ void Thread::UpdatePriority() {
 void Thread::BoostPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == THREADSTATUS_READY)
-        ready_queue.move(this, current_priority, priority);
-    else
-        ready_queue.prepare(priority);
+        scheduler->SetThreadPriority(this, current_priority, priority);
+    else if (status == THREADSTATUS_WAIT_ARB)
+        arbitration_queue.move(wait_address, this, current_priority, priority);
     current_priority = priority;
 }
 
 SharedPtr<Thread> SetupMainThread(VAddr entry_point, u32 priority,
                                   SharedPtr<Process> owner_process) {
     // Setup page table so we can write to memory
+    SetCurrentProcess(owner_process);
     SetCurrentPageTable(&Kernel::g_current_process->vm_manager.page_table);
 
     // Initialize new "main" thread
@@ -519,25 +471,6 @@ SharedPtr<Thread> SetupMainThread(VAddr entry_point, u32 priority,
     return thread;
 }
 
-bool HaveReadyThreads() {
-    return ready_queue.get_first() != nullptr;
-}
-
-void Reschedule() {
-    Thread* cur = GetCurrentThread();
-    Thread* next = PopNextReadyThread();
-
-    if (cur && next) {
-        LOG_TRACE(Kernel, "context switch %u -> %u", cur->GetObjectId(), next->GetObjectId());
-    } else if (cur) {
-        LOG_TRACE(Kernel, "context switch %u -> idle", cur->GetObjectId());
-    } else if (next) {
-        LOG_TRACE(Kernel, "context switch idle -> %u", next->GetObjectId());
-    }
-
-    SwitchContext(next);
-}
-
 void Thread::SetWaitSynchronizationResult(ResultCode result) {
     context.cpu_registers[0] = result.raw;
 }
@@ -563,18 +496,19 @@ VAddr Thread::GetCommandBufferAddress() const {
 void ThreadingInit() {
     ThreadWakeupEventType = CoreTiming::RegisterEvent("ThreadWakeupCallback", ThreadWakeupCallback);
 
-    current_thread = nullptr;
     next_thread_id = 1;
 }
 
 void ThreadingShutdown() {
-    current_thread = nullptr;
-
     for (auto& t : thread_list) {
         t->Stop();
     }
     thread_list.clear();
-    ready_queue.clear();
+    arbitration_queue.clear();
+
+    for (size_t core = 0; core < Core::NUM_CPU_CORES; ++core) {
+        Core::System::GetInstance().Scheduler(core)->Clear();
+    }
 }
 
 const std::vector<SharedPtr<Thread>>& GetThreadList() {
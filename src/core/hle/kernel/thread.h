@@ -4,13 +4,16 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 #include "common/common_types.h"
+#include "common/thread_queue_list.h"
 #include "core/arm/arm_interface.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/wait_object.h"
 #include "core/hle/result.h"
@@ -55,6 +58,7 @@ namespace Kernel {
 
 class Mutex;
 class Process;
+class Scheduler;
 
 class Thread final : public WaitObject {
 public:
@@ -127,6 +131,13 @@ public:
      */
     void ResumeFromWait();
 
+    /**
+     * Changes the core that the thread is run on and the cores it is allowed to migrate to
+     * @param core The new ideal core of the thread
+     * @param mask Bitmask of the cores that the thread may be run on
+     */
+    void ChangeCore(u32 core, u64 mask);
+
     /**
      * Schedules an event to wake up the specified thread after the specified delay
      * @param nanoseconds The time this thread will be allowed to sleep for
@@ -200,7 +211,16 @@ public:
 
     u64 last_running_ticks; ///< CPU tick when thread was last running
 
-    s32 processor_id;
+    s32 processor_id; ///< Core the thread is currently scheduled on
+
+    s32 ideal_core;    ///< Core the thread prefers to be run on
+    u64 affinity_mask; ///< Bitmask of the cores the thread is allowed to be run on
+
+    /// Scheduler of the core the thread is currently scheduled on
+    std::shared_ptr<Scheduler> scheduler;
+
+    /// Links of the thread in the ready queue of its scheduler, only used while it is ready
+    Common::ThreadQueueListNode<Thread> ready_queue_node;
 
     VAddr tls_address; ///< Virtual address of the Thread Local Storage of the thread
 
@@ -218,6 +238,9 @@ public:
 
     VAddr wait_address; ///< If waiting on an AddressArbiter, this is the arbitration address
 
+    /// Links of the thread in the wait queue of its arbitration address, while it is waiting on it
+    Common::ThreadQueueListNode<Thread> arbitration_node;
+
     std::string name;
 
     /// Handle used by guest emulated application to access this thread
@@ -226,6 +249,9 @@ public:
     /// Handle used as userdata to reference this object when inserting into the CoreTiming queue.
     Handle callback_handle;
 
+    /// The pending wakeup event, used to cancel it without searching the CoreTiming queue
+    CoreTiming::EventHandle wakeup_event = CoreTiming::INVALID_EVENT_HANDLE;
+
     using WakeupCallback = bool(ThreadWakeupReason reason, SharedPtr<Thread> thread,
                                 SharedPtr<WaitObject> object, size_t index);
     // Callback that will be invoked when the thread is resumed from a waiting state. If the thread
@@ -248,16 +274,6 @@ private:
 SharedPtr<Thread> SetupMainThread(VAddr entry_point, u32 priority,
                                   SharedPtr<Process> owner_process);
 
-/**
- * Returns whether there are any threads that are ready to run.
- */
-bool HaveReadyThreads();
-
-/**
- * Reschedules to the next available thread (call after current thread is suspended)
- */
-void Reschedule();
-
 /**
  * Arbitrate the highest priority thread that is waiting
  * @param address The address for which waiting threads should be arbitrated
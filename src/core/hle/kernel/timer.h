@@ -5,6 +5,7 @@
 #pragma once
 
 #include "common/common_types.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/wait_object.h"
 
@@ -69,6 +70,9 @@ private:
 
     /// Handle used as userdata to reference this object when inserting into the CoreTiming queue.
     Handle callback_handle;
+
+    /// The pending timer event, used to cancel it without searching the CoreTiming queue
+    CoreTiming::EventHandle timer_event = CoreTiming::INVALID_EVENT_HANDLE;
 };
 
 /// Initializes the required variables for timers
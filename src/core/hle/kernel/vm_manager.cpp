@@ -24,6 +24,18 @@ static const char* GetMemoryStateName(MemoryState state) {
     return names[(int)state];
 }
 
+/// Maps host memory into the address space of the ARM backend of every emulated CPU core
+static void MapBackingMemoryOnAllCores(VAddr target, u64 size, u8* memory) {
+    auto& system = Core::System::GetInstance();
+    if (!system.IsPoweredOn()) {
+        return;
+    }
+    for (size_t core = 0; core < Core::NUM_CPU_CORES; ++core) {
+        system.ArmInterface(core).MapBackingMemory(target, size, memory,
+                                                   VMAPermission::ReadWriteExecute);
+    }
+}
+
 bool VirtualMemoryArea::CanBeMergedWith(const VirtualMemoryArea& next) const {
     ASSERT(base + size == next.base);
     if (permissions != next.permissions || meminfo_state != next.meminfo_state ||
@@ -59,19 +71,27 @@ void VMManager::Reset() {
     initial_vma.size = MAX_ADDRESS;
     vma_map.emplace(initial_vma.base, initial_vma);
 
-    page_table.pointers.fill(nullptr);
-    page_table.attributes.fill(Memory::PageType::Unmapped);
-    page_table.cached_res_count.fill(0);
+    page_table.Clear();
 
-    UpdatePageTableForVMA(initial_vma);
+    last_vma = vma_map.end();
 }
 
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     if (target >= MAX_ADDRESS) {
         return vma_map.end();
-    } else {
-        return std::prev(vma_map.upper_bound(target));
     }
+    return std::prev(vma_map.upper_bound(target));
+}
+
+VMManager::VMAHandle VMManager::FindVMA(VAddr target) {
+    if (target >= MAX_ADDRESS) {
+        return vma_map.end();
+    }
+    if (last_vma != vma_map.end() && target - last_vma->second.base < last_vma->second.size) {
+        return last_vma;
+    }
+    last_vma = static_cast<const VMManager&>(*this).FindVMA(target);
+    return last_vma;
 }
 
 ResultVal<VMManager::VMAHandle> VMManager::MapMemoryBlock(VAddr target,
@@ -86,8 +106,7 @@ ResultVal<VMManager::VMAHandle> VMManager::MapMemoryBlock(VAddr target,
     VirtualMemoryArea& final_vma = vma_handle->second;
     ASSERT(final_vma.size == size);
 
-    Core::CPU().MapBackingMemory(target, size, block->data() + offset,
-                                 VMAPermission::ReadWriteExecute);
+    MapBackingMemoryOnAllCores(target, size, block->data() + offset);
 
     final_vma.type = VMAType::AllocatedMemoryBlock;
     final_vma.permissions = VMAPermission::ReadWrite;
@@ -108,7 +127,7 @@ ResultVal<VMManager::VMAHandle> VMManager::MapBackingMemory(VAddr target, u8* me
     VirtualMemoryArea& final_vma = vma_handle->second;
     ASSERT(final_vma.size == size);
 
-    Core::CPU().MapBackingMemory(target, size, memory, VMAPermission::ReadWriteExecute);
+    MapBackingMemoryOnAllCores(target, size, memory);
 
     final_vma.type = VMAType::BackingMemory;
     final_vma.permissions = VMAPermission::ReadWrite;
@@ -148,8 +167,6 @@ VMManager::VMAIter VMManager::Unmap(VMAIter vma_handle) {
     vma.backing_memory = nullptr;
     vma.paddr = 0;
 
-    UpdatePageTableForVMA(vma);
-
     return MergeAdjacent(vma_handle);
 }
 
@@ -164,6 +181,9 @@ ResultCode VMManager::UnmapRange(VAddr target, u64 size) {
         vma = std::next(Unmap(vma));
     }
 
+    // The range is a single free area now, so its pages are all unmapped at once
+    Memory::UnmapRegion(page_table, target, size);
+
     ASSERT(FindVMA(target)->second.size >= size);
     return RESULT_SUCCESS;
 }
@@ -171,9 +191,8 @@ ResultCode VMManager::UnmapRange(VAddr target, u64 size) {
 VMManager::VMAHandle VMManager::Reprotect(VMAHandle vma_handle, VMAPermission new_perms) {
     VMAIter iter = StripIterConstness(vma_handle);
 
-    VirtualMemoryArea& vma = iter->second;
-    vma.permissions = new_perms;
-    UpdatePageTableForVMA(vma);
+    // The page table doesn't hold the permissions, so it doesn't need to be updated
+    iter->second.permissions = new_perms;
 
     return MergeAdjacent(iter);
 }
@@ -322,14 +341,14 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     VMAIter next_vma = std::next(iter);
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
         iter->second.size += next_vma->second.size;
-        vma_map.erase(next_vma);
+        EraseVMA(next_vma);
     }
 
     if (iter != vma_map.begin()) {
         VMAIter prev_vma = std::prev(iter);
         if (prev_vma->second.CanBeMergedWith(iter->second)) {
             prev_vma->second.size += iter->second.size;
-            vma_map.erase(iter);
+            EraseVMA(iter);
             iter = prev_vma;
         }
     }
@@ -337,6 +356,13 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     return iter;
 }
 
+void VMManager::EraseVMA(VMAIter vma) {
+    if (vma == last_vma) {
+        last_vma = vma_map.end();
+    }
+    vma_map.erase(vma);
+}
+
 void VMManager::UpdatePageTableForVMA(const VirtualMemoryArea& vma) {
     switch (vma.type) {
     case VMAType::Free:
@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 #include "common/common_types.h"
+#include "core/hle/lock.h"
 #include "core/hle/result.h"
 #include "core/memory.h"
 #include "core/mmio.h"
@@ -123,9 +124,19 @@ public:
     /// Clears the address space map, re-initializing with a single free area.
     void Reset();
 
-    /// Finds the VMA in which the given address is included in, or `vma_map.end()`.
+    /**
+     * Finds the VMA in which the given address is included in, or `vma_map.end()`. This overload
+     * doesn't use the remembered VMA, as it may be called without holding `mutex`.
+     */
     VMAHandle FindVMA(VAddr target) const;
 
+    /**
+     * Finds the VMA in which the given address is included in, or `vma_map.end()`. The VMA found
+     * is remembered, as the following lookups are likely to fall into the same one. Only the
+     * holder of `mutex` may use this overload.
+     */
+    VMAHandle FindVMA(VAddr target);
+
     // TODO(yuriks): Should these functions actually return the handle?
 
     /**
@@ -202,13 +213,21 @@ public:
     /// is scheduled.
     Memory::PageTable page_table;
 
+    /**
+     * Protects the VMAs and the page table of this address space. VMManager doesn't take it by
+     * itself: it is held by the callers for the whole of a compound operation, such as growing the
+     * heap, and it can be taken without holding HLE::g_hle_lock. Memory accesses which look up
+     * the VMAs or the page directories take it as well, as those can be freed by an unmap.
+     */
+    mutable HLE::ProfiledMutex mutex{"VMManager lock"};
+
 private:
     using VMAIter = decltype(vma_map)::iterator;
 
     /// Converts a VMAHandle to a mutable VMAIter.
     VMAIter StripIterConstness(const VMAHandle& iter);
 
-    /// Unmaps the given VMA.
+    /// Marks the given VMA as free. The page table is left for the caller to update.
     VMAIter Unmap(VMAIter vma);
 
     /**
@@ -235,7 +254,13 @@ private:
      */
     VMAIter MergeAdjacent(VMAIter vma);
 
+    /// Removes a VMA from the map, forgetting it if it was the last one found.
+    void EraseVMA(VMAIter vma);
+
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
+
+    /// VMA in which the last lookup ended, or `vma_map.end()`.
+    VMAHandle last_vma;
 };
 } // namespace Kernel
@@ -2,8 +2,38 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <core/hle/lock.h>
+#include "common/microprofile.h"
+#include "core/hle/lock.h"
 
 namespace HLE {
-std::recursive_mutex g_hle_lock;
+
+ProfiledMutex::ProfiledMutex(const char* name) : name(name) {
+#if MICROPROFILE_ENABLED
+    wait_token =
+        MicroProfileGetToken("Kernel", name, MP_RGB(200, 70, 70), MicroProfileTokenTypeCpu);
+#endif
+}
+
+void ProfiledMutex::lock() {
+    if (mutex.try_lock()) {
+        return;
+    }
+
+    contention_count.fetch_add(1, std::memory_order_relaxed);
+    MICROPROFILE_META_CPU("Kernel lock contention", 1);
+    MICROPROFILE_SCOPE_TOKEN(wait_token);
+    mutex.lock();
+}
+
+bool ProfiledMutex::try_lock() {
+    return mutex.try_lock();
+}
+
+void ProfiledMutex::unlock() {
+    mutex.unlock();
 }
+
+ProfiledMutex g_hle_lock("HLE lock");
+ProfiledMutex g_memory_lock("Memory lock");
+
+} // namespace HLE
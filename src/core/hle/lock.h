@@ -4,9 +4,62 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
+#include "common/common_types.h"
 
 namespace HLE {
+
+/**
+ * Recursive mutex which counts how often it had to wait for another thread to release it. The
+ * time spent waiting shows up under the "Kernel" MicroProfile group with the name of the lock, and
+ * every contended acquisition is reported as a "Kernel lock contention" counter.
+ */
+class ProfiledMutex final {
+public:
+    explicit ProfiledMutex(const char* name);
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    /// Returns the name the lock is profiled under
+    const char* GetName() const {
+        return name;
+    }
+
+    /// Returns the number of times lock() found the mutex held by another thread
+    u64 GetContentionCount() const {
+        return contention_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::recursive_mutex mutex;
+    std::atomic<u64> contention_count{0};
+    const char* name;
+    u64 wait_token = 0; ///< MicroProfile timer token of the time spent waiting
+};
+
+/*
+ * The HLE kernel state is protected by a few locks, which must always be acquired in the following
+ * order (a thread holding one of them may only acquire the ones after it):
+ *
+ *  1. g_hle_lock: threads, schedulers, wait objects and their wait queues, address arbitration,
+ *     CoreTiming events and services. The schedulers stay under this lock as rescheduling changes
+ *     the state of threads that the SVCs are also working with.
+ *  2. VMManager::mutex: the address space of a single process (VMAs and page table). SVCs which
+ *     only work with the memory of the current process, such as SetHeapSize or QueryMemory, take
+ *     this lock instead of g_hle_lock. Every memory access that doesn't go through a host pointer
+ *     takes it too, as the VMAs and page directories it looks up can be freed by these SVCs.
+ *     Both find the current process through Kernel::GetCurrentProcess(), as g_current_process
+ *     itself needs g_hle_lock.
+ *  3. HandleTable::mutex: the handle table, whose lookups don't need any lock at all.
+ *  4. g_memory_lock: the slow path of emulated memory accesses (MMIO and rasterizer flushes).
+ */
+
 /*
  * Synchronizes access to the internal HLE kernel structures, it is acquired when a guest
  * application thread performs a syscall. It should be acquired by any host threads that read or
@@ -14,5 +67,9 @@ namespace HLE {
  * to the emulated memory is not protected by this mutex, and should be avoided in any threads other
  * than the CPU thread.
  */
-extern std::recursive_mutex g_hle_lock;
+extern ProfiledMutex g_hle_lock;
+
+/// Serializes the accesses to emulated memory which don't go through a host pointer
+extern ProfiledMutex g_memory_lock;
+
 } // namespace HLE
@@ -14,24 +14,24 @@ class IWindowController final : public ServiceFramework<IWindowController> {
 public:
     IWindowController() : ServiceFramework("IWindowController") {
         static const FunctionInfo functions[] = {
-            {1, &IWindowController::GetAppletResourceUserId, "GetAppletResourceUserId"},
-            {10, &IWindowController::AcquireForegroundRights, "AcquireForegroundRights"},
+            {1, &IWindowController::Marshal<&IWindowController::GetAppletResourceUserId>,
+             "GetAppletResourceUserId"},
+            {10, &IWindowController::Marshal<&IWindowController::AcquireForegroundRights>,
+             "AcquireForegroundRights"},
         };
         RegisterHandlers(functions);
     }
 
 private:
-    void GetAppletResourceUserId(Kernel::HLERequestContext& ctx) {
+    ResultCode GetAppletResourceUserId(u64& applet_resource_user_id) {
         LOG_WARNING(Service, "(STUBBED) called");
-        IPC::RequestBuilder rb{ctx, 4};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u64>(0);
+        applet_resource_user_id = 0;
+        return RESULT_SUCCESS;
     }
 
-    void AcquireForegroundRights(Kernel::HLERequestContext& ctx) {
+    ResultCode AcquireForegroundRights() {
         LOG_WARNING(Service, "(STUBBED) called");
-        IPC::RequestBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
+        return RESULT_SUCCESS;
     }
 };
 
@@ -76,8 +76,10 @@ public:
     ICommonStateGetter() : ServiceFramework("ICommonStateGetter") {
         static const FunctionInfo functions[] = {
             {0, &ICommonStateGetter::GetEventHandle, "GetEventHandle"},
-            {1, &ICommonStateGetter::ReceiveMessage, "ReceiveMessage"},
-            {9, &ICommonStateGetter::GetCurrentFocusState, "GetCurrentFocusState"},
+            {1, &ICommonStateGetter::Marshal<&ICommonStateGetter::ReceiveMessage>,
+             "ReceiveMessage"},
+            {9, &ICommonStateGetter::Marshal<&ICommonStateGetter::GetCurrentFocusState>,
+             "GetCurrentFocusState"},
         };
         RegisterHandlers(functions);
 
@@ -95,20 +97,18 @@ private:
         LOG_WARNING(Service, "(STUBBED) called");
     }
 
-    void ReceiveMessage(Kernel::HLERequestContext& ctx) {
-        IPC::RequestBuilder rb{ctx, 3};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(15);
+    ResultCode ReceiveMessage(u32& message) {
+        message = 15;
 
         LOG_WARNING(Service, "(STUBBED) called");
+        return RESULT_SUCCESS;
     }
 
-    void GetCurrentFocusState(Kernel::HLERequestContext& ctx) {
-        IPC::RequestBuilder rb{ctx, 3};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(1); // 1: In focus, 2/3: Out of focus(running in "background")
+    ResultCode GetCurrentFocusState(u32& focus_state) {
+        focus_state = 1; // 1: In focus, 2/3: Out of focus(running in "background")
 
         LOG_WARNING(Service, "(STUBBED) called");
+        return RESULT_SUCCESS;
     }
 
     Kernel::SharedPtr<Kernel::Event> event;
@@ -118,23 +118,19 @@ class IApplicationFunctions final : public ServiceFramework<IApplicationFunction
 public:
     IApplicationFunctions() : ServiceFramework("IApplicationFunctions") {
         static const FunctionInfo functions[] = {
-            {22, &IApplicationFunctions::SetTerminateResult, "SetTerminateResult"},
+            {22, &IApplicationFunctions::Marshal<&IApplicationFunctions::SetTerminateResult>,
+             "SetTerminateResult"},
         };
         RegisterHandlers(functions);
     }
 
 private:
-    void SetTerminateResult(Kernel::HLERequestContext& ctx) {
+    ResultCode SetTerminateResult(u32 result) {
         // Takes an input u32 Result, no output.
         // For example, in some cases official apps use this with error 0x2A2 then uses svcBreak.
 
-        IPC::RequestParser rp{ctx};
-        u32 result = rp.Pop<u32>();
-
-        IPC::RequestBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
-
         LOG_WARNING(Service, "(STUBBED) called, result=0x%08X", result);
+        return RESULT_SUCCESS;
     }
 };
 
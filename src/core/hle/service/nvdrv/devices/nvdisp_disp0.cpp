@@ -18,17 +18,30 @@ u32 nvdisp_disp0::ioctl(u32 command, const std::vector<u8>& input, std::vector<u
     return 0;
 }
 
-void nvdisp_disp0::flip(u32 buffer_handle, u32 offset, u32 format, u32 width, u32 height,
-                        u32 stride) {
-    VAddr addr = nvmap_dev->GetObjectAddress(buffer_handle);
-    LOG_WARNING(Service,
-                "Drawing from address %llx offset %08X Width %u Height %u Stride %u Format %u",
-                addr, offset, width, height, stride, format);
+u64 nvdisp_disp0::flip(const std::vector<boost::optional<LayerBuffer>>& layers) {
+    ASSERT_MSG(layers.size() <= RendererBase::MAX_LAYERS, "Too many layers to compose");
 
     using PixelFormat = RendererBase::FramebufferInfo::PixelFormat;
-    const RendererBase::FramebufferInfo framebuffer_info{
-        addr, offset, width, height, stride, static_cast<PixelFormat>(format)};
-    VideoCore::g_renderer->SwapBuffers(framebuffer_info);
+    RendererBase::Composition composition;
+    composition.num_layers = layers.size();
+    for (size_t i = 0; i < layers.size(); ++i) {
+        if (layers[i] == boost::none) {
+            continue;
+        }
+
+        const LayerBuffer& buffer = *layers[i];
+        const VAddr addr = nvmap_dev->GetObjectAddress(buffer.buffer_handle);
+        LOG_WARNING(Service,
+                    "Drawing layer %zu from address %llx offset %08X Width %u Height %u Stride %u "
+                    "Format %u",
+                    i, addr, buffer.offset, buffer.width, buffer.height, buffer.stride,
+                    buffer.format);
+
+        composition.framebuffers[i] = RendererBase::FramebufferInfo{
+            addr,          buffer.offset, buffer.width, buffer.height,
+            buffer.stride, static_cast<PixelFormat>(buffer.format)};
+    }
+    return VideoCore::SwapBuffers(composition);
 }
 
 } // namespace Devices
@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <vector>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "core/hle/service/nvdrv/devices/nvdevice.h"
 
@@ -20,10 +21,25 @@ public:
     nvdisp_disp0(std::shared_ptr<nvmap> nvmap_dev) : nvdevice(), nvmap_dev(std::move(nvmap_dev)) {}
     ~nvdisp_disp0() = default;
 
+    /// Buffer to display on one of the layers of a flip
+    struct LayerBuffer {
+        u32 buffer_handle;
+        u32 offset;
+        u32 format;
+        u32 width;
+        u32 height;
+        u32 stride;
+    };
+
     u32 ioctl(u32 command, const std::vector<u8>& input, std::vector<u8>& output) override;
 
-    /// Performs a screen flip, drawing the buffer pointed to by the handle.
-    void flip(u32 buffer_handle, u32 offset, u32 format, u32 width, u32 height, u32 stride);
+    /**
+     * Performs a screen flip, composing the layers of the display.
+     * @param layers Buffer newly queued on each layer, starting with the bottom one. Layers without
+     * one keep showing their previous contents.
+     * @return Fence that is signalled once the buffers have been read and may be reused
+     */
+    u64 flip(const std::vector<boost::optional<LayerBuffer>>& layers);
 
 private:
     std::shared_ptr<nvmap> nvmap_dev;
@@ -93,6 +93,27 @@ void ServiceFrameworkBase::RegisterHandlersBase(const FunctionInfoBase* function
         // Usually this array is sorted by id already, so hint to insert at the end
         handlers.emplace_hint(handlers.cend(), functions[i].expected_header, functions[i]);
     }
+
+    // Inserting may have moved the entries of the map, rebuild the jump table from scratch
+    handler_table.clear();
+    for (const auto& handler : handlers) {
+        if (handler.first >= MAX_DENSE_COMMAND_ID) {
+            break;
+        }
+        handler_table.resize(handler.first + 1, nullptr);
+        handler_table[handler.first] = &handler.second;
+    }
+}
+
+const ServiceFrameworkBase::FunctionInfoBase* ServiceFrameworkBase::FindHandler(u32 command) const {
+    if (command < handler_table.size()) {
+        return handler_table[command];
+    }
+    if (command < MAX_DENSE_COMMAND_ID) {
+        return nullptr;
+    }
+    auto itr = handlers.find(command);
+    return itr == handlers.end() ? nullptr : &itr->second;
 }
 
 void ServiceFrameworkBase::ReportUnimplementedFunction(Kernel::HLERequestContext& ctx,
@@ -113,8 +134,7 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(Kernel::HLERequestContext
 }
 
 void ServiceFrameworkBase::InvokeRequest(Kernel::HLERequestContext& ctx) {
-    auto itr = handlers.find(ctx.GetCommand());
-    const FunctionInfoBase* info = itr == handlers.end() ? nullptr : &itr->second;
+    const FunctionInfoBase* info = FindHandler(ctx.GetCommand());
     if (info == nullptr || info->handler_callback == nullptr) {
         return ReportUnimplementedFunction(ctx, info);
     }
@@ -7,6 +7,7 @@
 #include <cstddef>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include "common/bit_field.h"
 #include "common/common_types.h"
@@ -23,6 +24,12 @@ class ServerSession;
 class HLERequestContext;
 }
 
+namespace IPC {
+template <typename Self, typename... Args>
+void InvokeMarshalled(Self* self, ResultCode (Self::*handler)(Args...),
+                      Kernel::HLERequestContext& ctx);
+}
+
 namespace Service {
 
 namespace SM {
@@ -87,8 +94,12 @@ private:
     ~ServiceFrameworkBase();
 
     void RegisterHandlersBase(const FunctionInfoBase* functions, size_t n);
+    const FunctionInfoBase* FindHandler(u32 command) const;
     void ReportUnimplementedFunction(Kernel::HLERequestContext& ctx, const FunctionInfoBase* info);
 
+    /// Command ids below this value are dispatched through a dense jump table
+    static constexpr u32 MAX_DENSE_COMMAND_ID = 0x2000;
+
     /// Identifier string used to connect to the service.
     std::string service_name;
     /// Maximum number of concurrent sessions that this service can handle.
@@ -103,6 +114,12 @@ private:
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
     boost::container::flat_map<u32, FunctionInfoBase> handlers;
+
+    /**
+     * Dense jump table indexed by command id, pointing into `handlers`. Only covers ids below
+     * MAX_DENSE_COMMAND_ID, requests for larger ids fall back to searching `handlers`.
+     */
+    std::vector<const FunctionInfoBase*> handler_table;
 };
 
 /**
@@ -163,6 +180,16 @@ protected:
         RegisterHandlersBase(functions, n);
     }
 
+    /**
+     * Handler adapter which parses the request and writes the response based on the signature of
+     * `handler`, see IPC::InvokeMarshalled. Registered like any other handler:
+     * `{0, &Foo::Marshal<&Foo::Bar>, "Bar"}`, where `Bar` is `ResultCode Bar(u32 in, u64& out)`.
+     */
+    template <auto handler>
+    void Marshal(Kernel::HLERequestContext& ctx) {
+        IPC::InvokeMarshalled(static_cast<Self*>(this), handler, ctx);
+    }
+
 private:
     /**
      * This function is used to allow invocation of pointers to handlers stored in the base class
@@ -16,20 +16,18 @@ class ISystemClock final : public ServiceFramework<ISystemClock> {
 public:
     ISystemClock() : ServiceFramework("ISystemClock") {
         static const FunctionInfo functions[] = {
-            {0, &ISystemClock::GetCurrentTime, "GetCurrentTime"},
+            {0, &ISystemClock::Marshal<&ISystemClock::GetCurrentTime>, "GetCurrentTime"},
         };
         RegisterHandlers(functions);
     }
 
 private:
-    void GetCurrentTime(Kernel::HLERequestContext& ctx) {
-        const s64 time_since_epoch{std::chrono::duration_cast<std::chrono::milliseconds>(
-                                       std::chrono::system_clock::now().time_since_epoch())
-                                       .count()};
-        IPC::RequestBuilder rb{ctx, 4};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u64>(time_since_epoch);
+    ResultCode GetCurrentTime(s64& time_since_epoch) {
+        time_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
         LOG_DEBUG(Service, "called");
+        return RESULT_SUCCESS;
     }
 };
 
@@ -5,7 +5,9 @@
 #include <algorithm>
 
 #include "common/alignment.h"
+#include "common/bit_set.h"
 #include "common/scope_exit.h"
+#include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/service/nvdrv/devices/nvdisp_disp0.h"
@@ -254,19 +256,24 @@ public:
 
 class IGBPDequeueBufferResponseParcel : public Parcel {
 public:
-    IGBPDequeueBufferResponseParcel(u32 slot) : Parcel(), slot(slot) {}
+    IGBPDequeueBufferResponseParcel(u32 slot, s32 status = 0)
+        : Parcel(), slot(slot), status(status) {}
     ~IGBPDequeueBufferResponseParcel() override = default;
 
+    /// Status returned when there is no free buffer, as Android's WOULD_BLOCK
+    static constexpr s32 STATUS_WOULD_BLOCK = -11;
+
 protected:
     void SerializeData() override {
         Write(slot);
         // TODO(Subv): Find out how this Fence is used.
         std::array<u32_le, 11> fence = {};
         Write(fence);
-        Write<u32_le>(0);
+        Write(status);
     }
 
     u32_le slot;
+    s32_le status;
 };
 
 class IGBPRequestBufferRequestParcel : public Parcel {
@@ -360,8 +367,8 @@ public:
         : ServiceFramework("IHOSBinderDriver"), nv_flinger(std::move(nv_flinger)) {
         static const FunctionInfo functions[] = {
             {0, &IHOSBinderDriver::TransactParcel, "TransactParcel"},
-            {1, &IHOSBinderDriver::AdjustRefcount, "AdjustRefcount"},
-            {2, nullptr, "GetNativeHandle"},
+            {1, &IHOSBinderDriver::Marshal<&IHOSBinderDriver::AdjustRefcount>, "AdjustRefcount"},
+            {2, &IHOSBinderDriver::GetNativeHandle, "GetNativeHandle"},
             {3, nullptr, "TransactParcelAuto"},
         };
         RegisterHandlers(functions);
@@ -418,10 +425,13 @@ private:
         } else if (transaction == TransactionId::DequeueBuffer) {
             IGBPDequeueBufferRequestParcel request{input_data};
 
-            u32 slot = buffer_queue->DequeueBuffer(request.data.pixel_format, request.data.width,
-                                                   request.data.height);
+            auto slot = buffer_queue->DequeueBuffer(request.data.pixel_format, request.data.width,
+                                                    request.data.height);
 
-            IGBPDequeueBufferResponseParcel response{slot};
+            // When every buffer is in use, the application has to wait on the buffer wait event
+            // returned by GetNativeHandle before trying again.
+            const s32 status = slot ? 0 : IGBPDequeueBufferResponseParcel::STATUS_WOULD_BLOCK;
+            IGBPDequeueBufferResponseParcel response{slot.value_or(0), status};
             auto response_buffer = response.Serialize();
             Memory::WriteBlock(output_buffer.Address(), response_buffer.data(),
                                output_buffer.Size());
@@ -452,15 +462,23 @@ private:
         rb.Push(RESULT_SUCCESS);
     }
 
-    void AdjustRefcount(Kernel::HLERequestContext& ctx) {
+    void GetNativeHandle(Kernel::HLERequestContext& ctx) {
         IPC::RequestParser rp{ctx};
         u32 id = rp.Pop<u32>();
-        s32 addval = rp.PopRaw<s32>();
-        u32 type = rp.Pop<u32>();
+        u32 unknown = rp.Pop<u32>();
 
-        LOG_WARNING(Service, "(STUBBED) called id=%u, addval=%08X, type=%08X", id, addval, type);
-        IPC::RequestBuilder rb{ctx, 2};
+        LOG_DEBUG(Service, "called id=%u, unknown=%08X", id, unknown);
+
+        auto buffer_queue = nv_flinger->GetBufferQueue(id);
+
+        IPC::RequestBuilder rb = rp.MakeBuilder(2, 1, 0, 0);
         rb.Push(RESULT_SUCCESS);
+        rb.PushCopyObjects(buffer_queue->GetBufferWaitEvent());
+    }
+
+    ResultCode AdjustRefcount(u32 id, s32 addval, u32 type) {
+        LOG_WARNING(Service, "(STUBBED) called id=%u, addval=%08X, type=%08X", id, addval, type);
+        return RESULT_SUCCESS;
     }
 
     std::shared_ptr<NVFlinger> nv_flinger;
@@ -471,21 +489,17 @@ public:
     ISystemDisplayService() : ServiceFramework("ISystemDisplayService") {
         static const FunctionInfo functions[] = {
             {1200, nullptr, "GetZOrderCountMin"},
-            {2205, &ISystemDisplayService::SetLayerZ, "SetLayerZ"},
+            {2205, &ISystemDisplayService::Marshal<&ISystemDisplayService::SetLayerZ>,
+             "SetLayerZ"},
         };
         RegisterHandlers(functions);
     }
     ~ISystemDisplayService() = default;
 
 private:
-    void SetLayerZ(Kernel::HLERequestContext& ctx) {
+    ResultCode SetLayerZ(u64 layer_id, u64 z_value) {
         LOG_WARNING(Service, "(STUBBED) called");
-        IPC::RequestParser rp{ctx};
-        u64 layer_id = rp.Pop<u64>();
-        u64 z_value = rp.Pop<u64>();
-
-        IPC::RequestBuilder rb = rp.MakeBuilder(2, 0, 0, 0);
-        rb.Push(RESULT_SUCCESS);
+        return RESULT_SUCCESS;
     }
 };
 
@@ -494,48 +508,33 @@ public:
     IManagerDisplayService(std::shared_ptr<NVFlinger> nv_flinger)
         : ServiceFramework("IManagerDisplayService"), nv_flinger(std::move(nv_flinger)) {
         static const FunctionInfo functions[] = {
-            {1020, &IManagerDisplayService::CloseDisplay, "CloseDisplay"},
+            {1020, &IManagerDisplayService::Marshal<&IManagerDisplayService::CloseDisplay>,
+             "CloseDisplay"},
             {1102, nullptr, "GetDisplayResolution"},
-            {2010, &IManagerDisplayService::CreateManagedLayer, "CreateManagedLayer"},
-            {6000, &IManagerDisplayService::AddToLayerStack, "AddToLayerStack"},
+            {2010, &IManagerDisplayService::Marshal<&IManagerDisplayService::CreateManagedLayer>,
+             "CreateManagedLayer"},
+            {6000, &IManagerDisplayService::Marshal<&IManagerDisplayService::AddToLayerStack>,
+             "AddToLayerStack"},
         };
         RegisterHandlers(functions);
     }
     ~IManagerDisplayService() = default;
 
 private:
-    void CloseDisplay(Kernel::HLERequestContext& ctx) {
+    ResultCode CloseDisplay(u64 display) {
         LOG_WARNING(Service, "(STUBBED) called");
-        IPC::RequestParser rp{ctx};
-        u64 display = rp.Pop<u64>();
-
-        IPC::RequestBuilder rb = rp.MakeBuilder(2, 0, 0, 0);
-        rb.Push(RESULT_SUCCESS);
+        return RESULT_SUCCESS;
     }
 
-    void CreateManagedLayer(Kernel::HLERequestContext& ctx) {
+    ResultCode CreateManagedLayer(u32 unknown, u64 display, u64 aruid, u64& layer_id) {
         LOG_WARNING(Service, "(STUBBED) called");
-        IPC::RequestParser rp{ctx};
-        u32 unknown = rp.Pop<u32>();
-        rp.Skip(1, false);
-        u64 display = rp.Pop<u64>();
-        u64 aruid = rp.Pop<u64>();
-
-        u64 layer_id = nv_flinger->CreateLayer(display);
-
-        IPC::RequestBuilder rb = rp.MakeBuilder(4, 0, 0, 0);
-        rb.Push(RESULT_SUCCESS);
-        rb.Push(layer_id);
+        layer_id = nv_flinger->CreateLayer(display);
+        return RESULT_SUCCESS;
     }
 
-    void AddToLayerStack(Kernel::HLERequestContext& ctx) {
+    ResultCode AddToLayerStack(u32 stack, u64 layer_id) {
         LOG_WARNING(Service, "(STUBBED) called");
-        IPC::RequestParser rp{ctx};
-        u32 stack = rp.Pop<u32>();
-        u64 layer_id = rp.Pop<u64>();
-
-        IPC::RequestBuilder rb = rp.MakeBuilder(2, 0, 0, 0);
-        rb.Push(RESULT_SUCCESS);
+        return RESULT_SUCCESS;
     }
 
     std::shared_ptr<NVFlinger> nv_flinger;
@@ -690,7 +689,8 @@ u64 NVFlinger::OpenDisplay(const std::string& name) {
 u64 NVFlinger::CreateLayer(u64 display_id) {
     auto& display = GetDisplay(display_id);
 
-    ASSERT_MSG(display.layers.empty(), "Only one layer is supported per display at the moment");
+    ASSERT_MSG(display.layers.size() < RendererBase::MAX_LAYERS,
+               "Only %zu layers are supported per display", RendererBase::MAX_LAYERS);
 
     u64 layer_id = next_layer_id++;
     u32 buffer_queue_id = next_buffer_queue_id++;
@@ -737,6 +737,8 @@ Layer& NVFlinger::GetLayer(u64 display_id, u64 layer_id) {
 }
 
 void NVFlinger::Compose() {
+    using LayerBuffer = NVDRV::Devices::nvdisp_disp0::LayerBuffer;
+
     for (auto& display : displays) {
         // Trigger vsync for this display at the end of drawing
         SCOPE_EXIT({ display.vsync_event->Signal(); });
@@ -745,24 +747,27 @@ void NVFlinger::Compose() {
         if (display.layers.empty())
             continue;
 
-        // TODO(Subv): Support more than 1 layer.
-        ASSERT_MSG(display.layers.size() == 1, "Max 1 layer per display is supported");
-
-        Layer& layer = display.layers[0];
-        auto& buffer_queue = layer.buffer_queue;
-
-        // Search for a queued buffer and acquire it
-        auto buffer = buffer_queue->AcquireBuffer();
-
-        if (buffer == boost::none) {
-            // There was no queued buffer to draw, render previous frame
-            VideoCore::g_renderer->SwapBuffers({});
-            continue;
+        // Acquire the newly queued buffer of every layer. Layers without one are not uploaded
+        // again, they keep showing their previous buffer.
+        std::vector<boost::optional<LayerBuffer>> layer_buffers(display.layers.size());
+        std::vector<u32> acquired_slots(display.layers.size());
+        bool any_buffer_queued = false;
+        for (size_t i = 0; i < display.layers.size(); ++i) {
+            auto buffer = display.layers[i].buffer_queue->AcquireBuffer();
+            if (buffer == boost::none) {
+                continue;
+            }
+
+            const auto& igbp_buffer = buffer->igbp_buffer;
+            layer_buffers[i] =
+                LayerBuffer{igbp_buffer.gpu_buffer_id, igbp_buffer.offset, igbp_buffer.format,
+                            igbp_buffer.width,         igbp_buffer.height, igbp_buffer.stride};
+            acquired_slots[i] = buffer->slot;
+            any_buffer_queued = true;
         }
 
-        auto& igbp_buffer = buffer->igbp_buffer;
-
-        // Now send the buffer to the GPU for drawing.
+        // Now send the buffers to the GPU for drawing. Without any queued buffer, this renders the
+        // previous frame again.
         auto nvdrv = NVDRV::nvdrv_a.lock();
         ASSERT(nvdrv);
 
@@ -771,76 +776,136 @@ void NVFlinger::Compose() {
         auto nvdisp = nvdrv->GetDevice<NVDRV::Devices::nvdisp_disp0>("/dev/nvdisp_disp0");
         ASSERT(nvdisp);
 
-        nvdisp->flip(igbp_buffer.gpu_buffer_id, igbp_buffer.offset, igbp_buffer.format,
-                     igbp_buffer.width, igbp_buffer.height, igbp_buffer.stride);
+        const u64 fence = nvdisp->flip(layer_buffers);
+
+        // The buffers are handed back to the application right away, but they can't be dequeued
+        // again until the GPU is done reading them
+        for (size_t i = 0; i < display.layers.size(); ++i) {
+            auto& buffer_queue = display.layers[i].buffer_queue;
+            if (layer_buffers[i] != boost::none) {
+                buffer_queue->ReleaseBuffer(acquired_slots[i], fence);
+            } else {
+                // Buffers released by earlier frames may have become available in the meantime
+                buffer_queue->UpdateBufferWaitEvent();
+            }
+        }
+
+        if (any_buffer_queued) {
+            Core::System::GetInstance().perf_stats.EndGameFrame();
+        }
+    }
+}
+
+BufferQueue::BufferQueue(u32 id, u64 layer_id) : id(id), layer_id(layer_id) {
+    for (u32 slot = 0; slot < NUM_SLOTS; ++slot) {
+        buffers[slot].slot = slot;
+    }
+    buffer_wait_event =
+        Kernel::Event::Create(Kernel::ResetType::Sticky, "BufferQueue NativeHandle");
+}
+
+BufferQueue::Buffer& BufferQueue::GetBuffer(u32 slot) {
+    ASSERT_MSG(slot < NUM_SLOTS, "Invalid buffer slot %u", slot);
+    return buffers[slot];
+}
+
+const BufferQueue::Buffer& BufferQueue::GetBuffer(u32 slot) const {
+    ASSERT_MSG(slot < NUM_SLOTS, "Invalid buffer slot %u", slot);
+    return buffers[slot];
+}
+
+void BufferQueue::MarkFree(u32 slot) {
+    buffers[slot].status = Buffer::Status::Free;
+    free_slots |= u64(1) << slot;
+}
 
-        buffer_queue->ReleaseBuffer(buffer->slot);
+boost::optional<u32> BufferQueue::FindDequeueableSlot() const {
+    for (u64 candidates = free_slots; candidates != 0; candidates &= candidates - 1) {
+        const u32 slot = static_cast<u32>(Common::LeastSignificantSetBit(candidates));
+        const auto& igbp_buffer = buffers[slot].igbp_buffer;
+        if (dequeue_parameters != boost::none &&
+            (igbp_buffer.format != dequeue_parameters->pixel_format ||
+             igbp_buffer.width != dequeue_parameters->width ||
+             igbp_buffer.height != dequeue_parameters->height)) {
+            continue;
+        }
+        if (VideoCore::IsFenceSignalled(buffers[slot].release_fence)) {
+            return slot;
+        }
     }
+    return boost::none;
 }
 
-BufferQueue::BufferQueue(u32 id, u64 layer_id) : id(id), layer_id(layer_id) {}
+void BufferQueue::UpdateBufferWaitEvent() {
+    if (FindDequeueableSlot() != boost::none) {
+        buffer_wait_event->Signal();
+    } else {
+        buffer_wait_event->Clear();
+    }
+}
 
 void BufferQueue::SetPreallocatedBuffer(u32 slot, IGBPBuffer& igbp_buffer) {
-    Buffer buffer{};
-    buffer.slot = slot;
+    auto& buffer = GetBuffer(slot);
+    ASSERT(buffer.status == Buffer::Status::Unallocated);
     buffer.igbp_buffer = igbp_buffer;
-    buffer.status = Buffer::Status::Free;
+    buffer.release_fence = 0;
 
     LOG_WARNING(Service, "Adding graphics buffer %u", slot);
 
-    queue.emplace_back(buffer);
+    MarkFree(slot);
+    UpdateBufferWaitEvent();
 }
 
-u32 BufferQueue::DequeueBuffer(u32 pixel_format, u32 width, u32 height) {
-    auto itr = std::find_if(queue.begin(), queue.end(), [&](const Buffer& buffer) {
-        // Only consider free buffers. Buffers become free once again after they've been Acquired
-        // and Released by the compositor, see the NVFlinger::Compose method.
-        if (buffer.status != Buffer::Status::Free)
-            return false;
-
-        // Make sure that the parameters match.
-        auto& igbp_buffer = buffer.igbp_buffer;
-        return igbp_buffer.format == pixel_format && igbp_buffer.width == width &&
-               igbp_buffer.height == height;
-    });
-    ASSERT(itr != queue.end());
+boost::optional<u32> BufferQueue::DequeueBuffer(u32 pixel_format, u32 width, u32 height) {
+    // Only free buffers are considered, buffers become free once again after they've been
+    // Acquired and Released by the compositor, see the NVFlinger::Compose method. Buffers the GPU
+    // is still reading are skipped rather than waited for, as that would stall every core.
+    dequeue_parameters = DequeueParameters{pixel_format, width, height};
+    const boost::optional<u32> usable_slot = FindDequeueableSlot();
 
-    itr->status = Buffer::Status::Dequeued;
-    return itr->slot;
+    if (usable_slot != boost::none) {
+        buffers[*usable_slot].status = Buffer::Status::Dequeued;
+        free_slots &= ~(u64(1) << *usable_slot);
+    }
+    UpdateBufferWaitEvent();
+    return usable_slot;
 }
 
 const IGBPBuffer& BufferQueue::RequestBuffer(u32 slot) const {
-    auto itr = std::find_if(queue.begin(), queue.end(),
-                            [&](const Buffer& buffer) { return buffer.slot == slot; });
-    ASSERT(itr != queue.end());
-    ASSERT(itr->status == Buffer::Status::Dequeued);
-    return itr->igbp_buffer;
+    const auto& buffer = GetBuffer(slot);
+    ASSERT(buffer.status == Buffer::Status::Dequeued);
+    return buffer.igbp_buffer;
 }
 
 void BufferQueue::QueueBuffer(u32 slot) {
-    auto itr = std::find_if(queue.begin(), queue.end(),
-                            [&](const Buffer& buffer) { return buffer.slot == slot; });
-    ASSERT(itr != queue.end());
-    ASSERT(itr->status == Buffer::Status::Dequeued);
-    itr->status = Buffer::Status::Queued;
+    auto& buffer = GetBuffer(slot);
+    ASSERT(buffer.status == Buffer::Status::Dequeued);
+    buffer.status = Buffer::Status::Queued;
+
+    ASSERT(num_queued < NUM_SLOTS);
+    queued_slots[(queued_head + num_queued) % NUM_SLOTS] = slot;
+    ++num_queued;
 }
 
 boost::optional<const BufferQueue::Buffer&> BufferQueue::AcquireBuffer() {
-    auto itr = std::find_if(queue.begin(), queue.end(), [](const Buffer& buffer) {
-        return buffer.status == Buffer::Status::Queued;
-    });
-    if (itr == queue.end())
+    if (num_queued == 0)
         return boost::none;
-    itr->status = Buffer::Status::Acquired;
-    return *itr;
+
+    auto& buffer = buffers[queued_slots[queued_head]];
+    queued_head = (queued_head + 1) % NUM_SLOTS;
+    --num_queued;
+
+    ASSERT(buffer.status == Buffer::Status::Queued);
+    buffer.status = Buffer::Status::Acquired;
+    return buffer;
 }
 
-void BufferQueue::ReleaseBuffer(u32 slot) {
-    auto itr = std::find_if(queue.begin(), queue.end(),
-                            [&](const Buffer& buffer) { return buffer.slot == slot; });
-    ASSERT(itr != queue.end());
-    ASSERT(itr->status == Buffer::Status::Acquired);
-    itr->status = Buffer::Status::Free;
+void BufferQueue::ReleaseBuffer(u32 slot, u64 fence) {
+    auto& buffer = GetBuffer(slot);
+    ASSERT(buffer.status == Buffer::Status::Acquired);
+    buffer.release_fence = fence;
+    MarkFree(slot);
+    UpdateBufferWaitEvent();
 }
 
 Layer::Layer(u64 id, std::shared_ptr<BufferQueue> queue) : id(id), buffer_queue(std::move(queue)) {}
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <boost/optional.hpp>
 #include "core/hle/kernel/event.h"
@@ -40,30 +41,78 @@ public:
     BufferQueue(u32 id, u64 layer_id);
     ~BufferQueue() = default;
 
+    /// Number of buffer slots of a queue, as in Android's BufferQueue
+    static constexpr u32 NUM_SLOTS = 64;
+
     struct Buffer {
-        enum class Status { Free = 0, Queued = 1, Dequeued = 2, Acquired = 3 };
+        enum class Status { Unallocated = 0, Free = 1, Queued = 2, Dequeued = 3, Acquired = 4 };
 
         u32 slot;
-        Status status = Status::Free;
+        Status status = Status::Unallocated;
         IGBPBuffer igbp_buffer;
+        /// Fence of the last presentation of the buffer, it can't be reused before it's signalled
+        u64 release_fence = 0;
     };
 
     void SetPreallocatedBuffer(u32 slot, IGBPBuffer& buffer);
-    u32 DequeueBuffer(u32 pixel_format, u32 width, u32 height);
+    /**
+     * Dequeues a free buffer matching the given parameters, which the GPU is done reading.
+     * @returns The slot of the buffer, or none if there is no such buffer. The buffer wait event
+     * is signalled again once one is available.
+     */
+    boost::optional<u32> DequeueBuffer(u32 pixel_format, u32 width, u32 height);
     const IGBPBuffer& RequestBuffer(u32 slot) const;
     void QueueBuffer(u32 slot);
+    /// Acquires the oldest queued buffer, if any
     boost::optional<const Buffer&> AcquireBuffer();
-    void ReleaseBuffer(u32 slot);
+    void ReleaseBuffer(u32 slot, u64 fence);
 
     u32 GetId() const {
         return id;
     }
 
+    /**
+     * Returns the event signalled while the queue has a buffer which can be dequeued with the
+     * parameters of the last DequeueBuffer call
+     */
+    Kernel::SharedPtr<Kernel::Event> GetBufferWaitEvent() const {
+        return buffer_wait_event;
+    }
+
+    /**
+     * Signals or clears the buffer wait event, depending on whether a buffer can be dequeued. The
+     * compositor calls this every frame, to catch the buffers the GPU finished reading since.
+     */
+    void UpdateBufferWaitEvent();
+
 private:
+    struct DequeueParameters {
+        u32 pixel_format;
+        u32 width;
+        u32 height;
+    };
+
+    /// Finds a free buffer the GPU is done reading, which matches the last dequeue parameters
+    boost::optional<u32> FindDequeueableSlot() const;
+    Buffer& GetBuffer(u32 slot);
+    const Buffer& GetBuffer(u32 slot) const;
+    void MarkFree(u32 slot);
+
     u32 id;
     u64 layer_id;
 
-    std::vector<Buffer> queue;
+    /// Buffers indexed by their slot
+    std::array<Buffer, NUM_SLOTS> buffers;
+    /// Bit i is set when the buffer of slot i is free
+    u64 free_slots = 0;
+    /// Queued slots in the order they were queued in, as a ring of num_queued entries
+    std::array<u32, NUM_SLOTS> queued_slots;
+    u32 queued_head = 0;
+    u32 num_queued = 0;
+
+    /// Parameters of the last dequeue, any free buffer is dequeueable before the first one
+    boost::optional<DequeueParameters> dequeue_parameters;
+    Kernel::SharedPtr<Kernel::Event> buffer_wait_event;
 };
 
 struct Layer {
@@ -0,0 +1,101 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/launch_metrics.h"
+
+namespace Core {
+
+class LaunchMetrics::Reader final : public LinearDiskCacheReader<u64, ModuleInfo> {
+public:
+    explicit Reader(std::unordered_map<u64, ModuleInfo>& modules) : modules(modules) {}
+
+    void Read(const u64& key, const ModuleInfo* value, u32 value_size) override {
+        // Entries are only ever appended, so later entries supersede earlier ones.
+        if (value_size == 1) {
+            modules[key] = *value;
+        }
+    }
+
+private:
+    std::unordered_map<u64, ModuleInfo>& modules;
+};
+
+LaunchMetrics::LaunchMetrics() = default;
+
+LaunchMetrics::~LaunchMetrics() {
+    Close();
+}
+
+void LaunchMetrics::Open() {
+    Close();
+
+    const std::string path = FileUtil::GetUserPath(D_CACHE_IDX) + "launch_metrics.bin";
+    FileUtil::CreateFullPath(path);
+
+    Reader reader{modules};
+    const u32 num_entries = disk_cache.OpenAndRead(path.c_str(), reader);
+    is_open = true;
+
+    LOG_DEBUG(Core, "Read %u launch metrics entries from %s", num_entries, path.c_str());
+
+    if (num_entries > modules.size()) {
+        // Every session appends a new entry per module, so drop the superseded ones by rewriting
+        // the file with only the latest entry of each module.
+        disk_cache.Close();
+        FileUtil::Delete(path);
+        disk_cache.OpenAndRead(path.c_str(), reader);
+        for (const auto& module : modules) {
+            disk_cache.Append(module.first, &module.second, 1);
+        }
+        disk_cache.Sync();
+    }
+}
+
+void LaunchMetrics::Close() {
+    if (!is_open) {
+        return;
+    }
+
+    for (u64 hash : session_modules) {
+        disk_cache.Append(hash, &modules[hash], 1);
+    }
+    disk_cache.Sync();
+    disk_cache.Close();
+
+    is_open = false;
+    modules.clear();
+    session_modules.clear();
+}
+
+boost::optional<LaunchMetrics::ModuleInfo> LaunchMetrics::RegisterModule(u64 hash, u64 code_size) {
+    boost::optional<ModuleInfo> previous;
+
+    auto itr = modules.find(hash);
+    if (itr != modules.end() && itr->second.code_size == code_size) {
+        previous = itr->second;
+        LOG_INFO(Core,
+                 "Module %016" PRIx64 " was launched %" PRIu64 " times before, last startup took "
+                 "%" PRIu64 " us",
+                 hash, itr->second.launch_count, itr->second.startup_time_us);
+    }
+
+    ModuleInfo info{};
+    info.code_size = code_size;
+    info.launch_count = previous ? previous->launch_count + 1 : 1;
+    modules[hash] = info;
+    session_modules.push_back(hash);
+
+    return previous;
+}
+
+void LaunchMetrics::SetStartupTime(u64 startup_time_us) {
+    for (u64 hash : session_modules) {
+        modules[hash].startup_time_us = startup_time_us;
+    }
+}
+
+} // namespace Core
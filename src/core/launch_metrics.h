@@ -0,0 +1,64 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "common/linear_disk_cache.h"
+
+namespace Core {
+
+/**
+ * Persistent, on-disk record of the code modules run by emulated applications, keyed by a hash of
+ * the module's code. It keeps how often each module was launched and how long the application took
+ * to get to its first frame, so that startup times can be compared across launches.
+ */
+class LaunchMetrics {
+public:
+    struct ModuleInfo {
+        u64 code_size;
+        u64 launch_count;
+        /// Walltime between loading and the first presented frame in microseconds, 0 if unknown
+        u64 startup_time_us;
+    };
+
+    LaunchMetrics();
+    ~LaunchMetrics();
+
+    /// Opens the metrics file in the user cache directory, reading any existing entries.
+    void Open();
+
+    /// Writes out the metadata gathered this session and closes the metrics file.
+    void Close();
+
+    /**
+     * Registers a module that was loaded in the current session.
+     * @param hash Hash of the module's code
+     * @param code_size Size of the module's code in bytes
+     * @returns The metadata persisted by previous sessions, if the module was seen before
+     */
+    boost::optional<ModuleInfo> RegisterModule(u64 hash, u64 code_size);
+
+    /**
+     * Records the startup time of the current session for every module registered so far.
+     * @param startup_time_us Walltime between loading and the first presented frame
+     */
+    void SetStartupTime(u64 startup_time_us);
+
+private:
+    class Reader;
+
+    LinearDiskCache<u64, ModuleInfo> disk_cache;
+    bool is_open = false;
+
+    /// Metadata of all the known modules, including those of this session
+    std::unordered_map<u64, ModuleInfo> modules;
+    /// Hashes of the modules loaded in the current session
+    std::vector<u64> session_modules;
+};
+
+} // namespace Core
@@ -6,8 +6,10 @@
 #include <lz4.h>
 
 #include "common/common_funcs.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
+#include "core/core.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
 #include "core/loader/nso.h"
@@ -117,6 +119,12 @@ VAddr AppLoader_NSO::LoadNso(const std::string& path, VAddr load_base, bool relo
         codeset->segments[i].size = PageAlignSize(static_cast<u32>(data.size()));
     }
 
+    // Register the module's code with the launch metrics, keyed by its hash. This is done before
+    // any relocations are applied, so that the key does not depend on the load address.
+    const auto& text = nso_header.segments[0];
+    const u64 code_hash = Common::ComputeHash64(program_image.data() + text.location, text.size);
+    Core::System::GetInstance().launch_metrics.RegisterModule(code_hash, text.size);
+
     // MOD header pointer is at .text offset + 4
     u32 module_offset;
     std::memcpy(&module_offset, program_image.data() + 4, sizeof(u32));
@@ -2,11 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <mutex>
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/memory_util.h"
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
@@ -27,8 +31,12 @@ static PageTable* current_page_table = nullptr;
 
 void SetCurrentPageTable(PageTable* page_table) {
     current_page_table = page_table;
-    if (Core::System::GetInstance().IsPoweredOn()) {
-        Core::CPU().PageTableChanged();
+
+    auto& system = Core::System::GetInstance();
+    if (system.IsPoweredOn()) {
+        for (size_t core = 0; core < Core::NUM_CPU_CORES; ++core) {
+            system.ArmInterface(core).PageTableChanged();
+        }
     }
 }
 
@@ -36,24 +44,99 @@ PageTable* GetCurrentPageTable() {
     return current_page_table;
 }
 
+/// Size in bytes of the pointers of a single page directory
+constexpr size_t PAGE_DIRECTORY_POINTERS_SIZE = PAGE_DIRECTORY_NUM_ENTRIES * sizeof(u8*);
+
+PageTable::PageTable() {
+    static_assert(PAGE_DIRECTORY_POINTERS_SIZE % PAGE_SIZE == 0,
+                  "The pointers of a directory must span whole host pages");
+
+    pointers = static_cast<u8**>(AllocateMemoryPages(PAGE_TABLE_NUM_ENTRIES * sizeof(u8*)));
+    ASSERT_MSG(pointers != nullptr, "Failed to reserve the page table");
+}
+
+PageTable::~PageTable() {
+    FreeMemoryPages(pointers, PAGE_TABLE_NUM_ENTRIES * sizeof(u8*));
+}
+
+void PageTable::Clear() {
+    ReleaseDirectories(0, PAGE_TABLE_NUM_ENTRIES);
+    special_regions.clear();
+}
+
+PageDirectory& PageTable::GetDirectory(size_t page) {
+    auto& directory = directories[page >> PAGE_DIRECTORY_BITS];
+    if (directory == nullptr) {
+        directory = std::make_unique<PageDirectory>();
+    }
+    return *directory;
+}
+
+void PageTable::ReleaseDirectories(size_t first_page, size_t num_pages) {
+    ASSERT((first_page & PAGE_DIRECTORY_MASK) == 0 && (num_pages & PAGE_DIRECTORY_MASK) == 0);
+
+    const size_t first_directory = first_page >> PAGE_DIRECTORY_BITS;
+    const size_t num_directories = num_pages >> PAGE_DIRECTORY_BITS;
+    for (size_t i = first_directory; i < first_directory + num_directories; ++i) {
+        directories[i] = nullptr;
+    }
+
+    // The pointers read back as null afterwards, without the host having to keep pages of zeros
+    DecommitMemoryPages(pointers + first_page, num_directories * PAGE_DIRECTORY_POINTERS_SIZE);
+}
+
+/// Sets the type of the pages in [begin, end), filling each directory in a single pass
+static void SetPageAttributes(PageTable& page_table, VAddr begin, VAddr end, PageType type) {
+    for (VAddr page = begin; page < end;) {
+        const VAddr directory_end =
+            std::min<VAddr>(end, Common::AlignDown(page, PAGE_DIRECTORY_NUM_ENTRIES) +
+                                     PAGE_DIRECTORY_NUM_ENTRIES);
+
+        // Unmapping pages from a directory which was never allocated has nothing to do
+        PageDirectory* directory = type == PageType::Unmapped ? page_table.FindDirectory(page)
+                                                              : &page_table.GetDirectory(page);
+        if (directory != nullptr) {
+            const size_t offset = page & PAGE_DIRECTORY_MASK;
+            std::fill_n(directory->attributes.begin() + offset, directory_end - page, type);
+            std::fill_n(directory->cached_res_count.begin() + offset, directory_end - page, 0);
+        }
+        page = directory_end;
+    }
+}
+
 static void MapPages(PageTable& page_table, VAddr base, u64 size, u8* memory, PageType type) {
     LOG_DEBUG(HW_Memory, "Mapping %p onto %08X-%08X", memory, base * PAGE_SIZE,
               (base + size) * PAGE_SIZE);
 
+    ASSERT_MSG(base + size <= PAGE_TABLE_NUM_ENTRIES, "out of range mapping at %08X",
+               base + size);
+
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
-    VAddr end = base + size;
-    while (base != end) {
-        ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at %08X", base);
+    const VAddr end = base + size;
+    if (type == PageType::Unmapped) {
+        // Whole directories inside of the range are released rather than filled
+        const VAddr first_full = Common::AlignUp(base, PAGE_DIRECTORY_NUM_ENTRIES);
+        const VAddr last_full = Common::AlignDown(end, PAGE_DIRECTORY_NUM_ENTRIES);
+        if (first_full < last_full) {
+            page_table.ReleaseDirectories(first_full, last_full - first_full);
+            SetPageAttributes(page_table, base, first_full, type);
+            SetPageAttributes(page_table, last_full, end, type);
+            std::fill(page_table.pointers + base, page_table.pointers + first_full, nullptr);
+            std::fill(page_table.pointers + last_full, page_table.pointers + end, nullptr);
+            return;
+        }
+    }
 
-        page_table.attributes[base] = type;
-        page_table.pointers[base] = memory;
-        page_table.cached_res_count[base] = 0;
+    SetPageAttributes(page_table, base, end, type);
 
-        base += 1;
-        if (memory != nullptr)
-            memory += PAGE_SIZE;
+    if (memory == nullptr) {
+        std::fill(page_table.pointers + base, page_table.pointers + end, nullptr);
+        return;
+    }
+    for (u64 page = 0; page < size; ++page) {
+        page_table.pointers[base + page] = memory + page * PAGE_SIZE;
     }
 }
 
@@ -77,6 +160,18 @@ void UnmapRegion(PageTable& page_table, VAddr base, u64 size) {
     MapPages(page_table, base / PAGE_SIZE, size / PAGE_SIZE, nullptr, PageType::Unmapped);
 }
 
+/**
+ * Locks the address space of a process, so that its VMAs and page directories can't be freed while
+ * they are being looked up. Accesses which only go through the host pointers don't need this.
+ */
+static std::unique_lock<HLE::ProfiledMutex> LockAddressSpace(const Kernel::Process& process) {
+    return std::unique_lock<HLE::ProfiledMutex>(process.vm_manager.mutex);
+}
+
+static std::unique_lock<HLE::ProfiledMutex> LockAddressSpace() {
+    return LockAddressSpace(*Kernel::GetCurrentProcess());
+}
+
 /**
  * Gets a pointer to the exact memory at the virtual address (i.e. not page aligned)
  * using a VMA from the current process
@@ -111,7 +206,7 @@ static u8* GetPointerFromVMA(const Kernel::Process& process, VAddr vaddr) {
  * using a VMA from the current process.
  */
 static u8* GetPointerFromVMA(VAddr vaddr) {
-    return GetPointerFromVMA(*Kernel::g_current_process, vaddr);
+    return GetPointerFromVMA(*Kernel::GetCurrentProcess(), vaddr);
 }
 
 /**
@@ -128,7 +223,7 @@ static MMIORegionPointer GetMMIOHandler(const PageTable& page_table, VAddr vaddr
 }
 
 static MMIORegionPointer GetMMIOHandler(VAddr vaddr) {
-    const PageTable& page_table = Kernel::g_current_process->vm_manager.page_table;
+    const PageTable& page_table = Kernel::GetCurrentProcess()->vm_manager.page_table;
     return GetMMIOHandler(page_table, vaddr);
 }
 
@@ -145,10 +240,11 @@ T Read(const VAddr vaddr) {
         return value;
     }
 
-    // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
+    // The memory access might do an MMIO or cached access, so we have to serialize it
+    const auto address_space_lock = LockAddressSpace();
+    std::lock_guard<HLE::ProfiledMutex> lock(HLE::g_memory_lock);
 
-    PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
+    PageType type = current_page_table->GetAttribute(vaddr >> PAGE_BITS);
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "unmapped Read%lu @ 0x%llx", sizeof(T) * 8, vaddr);
@@ -186,10 +282,11 @@ void Write(const VAddr vaddr, const T data) {
         return;
     }
 
-    // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
+    // The memory access might do an MMIO or cached access, so we have to serialize it
+    const auto address_space_lock = LockAddressSpace();
+    std::lock_guard<HLE::ProfiledMutex> lock(HLE::g_memory_lock);
 
-    PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
+    PageType type = current_page_table->GetAttribute(vaddr >> PAGE_BITS);
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "unmapped Write%lu 0x%08X @ 0x%08X", sizeof(data) * 8, (u32)data,
@@ -223,10 +320,12 @@ bool IsValidVirtualAddress(const Kernel::Process& process, const VAddr vaddr) {
     if (page_pointer)
         return true;
 
-    if (page_table.attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory)
+    const auto address_space_lock = LockAddressSpace(process);
+
+    if (page_table.GetAttribute(vaddr >> PAGE_BITS) == PageType::RasterizerCachedMemory)
         return true;
 
-    if (page_table.attributes[vaddr >> PAGE_BITS] != PageType::Special)
+    if (page_table.GetAttribute(vaddr >> PAGE_BITS) != PageType::Special)
         return false;
 
     MMIORegionPointer mmio_region = GetMMIOHandler(page_table, vaddr);
@@ -238,7 +337,7 @@ bool IsValidVirtualAddress(const Kernel::Process& process, const VAddr vaddr) {
 }
 
 bool IsValidVirtualAddress(const VAddr vaddr) {
-    return IsValidVirtualAddress(*Kernel::g_current_process, vaddr);
+    return IsValidVirtualAddress(*Kernel::GetCurrentProcess(), vaddr);
 }
 
 bool IsValidPhysicalAddress(const PAddr paddr) {
@@ -251,7 +350,8 @@ u8* GetPointer(const VAddr vaddr) {
         return page_pointer + (vaddr & PAGE_MASK);
     }
 
-    if (current_page_table->attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory) {
+    const auto address_space_lock = LockAddressSpace();
+    if (current_page_table->GetAttribute(vaddr >> PAGE_BITS) == PageType::RasterizerCachedMemory) {
         return GetPointerFromVMA(vaddr);
     }
 
@@ -337,6 +437,8 @@ void RasterizerMarkRegionCached(PAddr start, u64 size, int count_delta) {
         return;
     }
 
+    const auto address_space_lock = LockAddressSpace();
+
     u64 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
     PAddr paddr = start;
 
@@ -353,14 +455,21 @@ void RasterizerMarkRegionCached(PAddr start, u64 size, int count_delta) {
         }
         VAddr vaddr = *maybe_vaddr;
 
-        u8& res_count = current_page_table->cached_res_count[vaddr >> PAGE_BITS];
+        const size_t page = vaddr >> PAGE_BITS;
+        PageDirectory* directory = current_page_table->FindDirectory(page);
+        if (directory == nullptr) {
+            // Nothing was ever mapped around this page
+            continue;
+        }
+
+        u8& res_count = directory->cached_res_count[page & PAGE_DIRECTORY_MASK];
         ASSERT_MSG(count_delta <= UINT8_MAX - res_count,
                    "Rasterizer resource cache counter overflow!");
         ASSERT_MSG(count_delta >= -res_count, "Rasterizer resource cache counter underflow!");
 
         // Switch page type to cached if now cached
         if (res_count == 0) {
-            PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
+            PageType& page_type = directory->attributes[page & PAGE_DIRECTORY_MASK];
             switch (page_type) {
             case PageType::Unmapped:
                 // It is not necessary for a process to have this region mapped into its address
@@ -368,7 +477,7 @@ void RasterizerMarkRegionCached(PAddr start, u64 size, int count_delta) {
                 break;
             case PageType::Memory:
                 page_type = PageType::RasterizerCachedMemory;
-                current_page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                current_page_table->pointers[page] = nullptr;
                 break;
             case PageType::Special:
                 page_type = PageType::RasterizerCachedSpecial;
@@ -382,7 +491,7 @@ void RasterizerMarkRegionCached(PAddr start, u64 size, int count_delta) {
 
         // Switch page type to uncached if now uncached
         if (res_count == 0) {
-            PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
+            PageType& page_type = directory->attributes[page & PAGE_DIRECTORY_MASK];
             switch (page_type) {
             case PageType::Unmapped:
                 // It is not necessary for a process to have this region mapped into its address
@@ -397,7 +506,7 @@ void RasterizerMarkRegionCached(PAddr start, u64 size, int count_delta) {
                     page_type = PageType::Unmapped;
                 } else {
                     page_type = PageType::Memory;
-                    current_page_table->pointers[vaddr >> PAGE_BITS] = pointer;
+                    current_page_table->pointers[page] = pointer;
                 }
                 break;
             }
@@ -442,6 +551,7 @@ u64 Read64(const VAddr addr) {
 void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
                const size_t size) {
     auto& page_table = process.vm_manager.page_table;
+    const auto address_space_lock = LockAddressSpace(process);
 
     size_t remaining_size = size;
     size_t page_index = src_addr >> PAGE_BITS;
@@ -451,7 +561,7 @@ void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_
         const size_t copy_amount = std::min<size_t>(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (page_table.attributes[page_index]) {
+        switch (page_table.GetAttribute(page_index)) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory, "unmapped ReadBlock @ 0x%08X (start address = 0xllx, size = %zu)",
                       current_vaddr, src_addr, size);
@@ -497,7 +607,7 @@ void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_
 }
 
 void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
-    ReadBlock(*Kernel::g_current_process, src_addr, dest_buffer, size);
+    ReadBlock(*Kernel::GetCurrentProcess(), src_addr, dest_buffer, size);
 }
 
 void Write8(const VAddr addr, const u8 data) {
@@ -519,6 +629,7 @@ void Write64(const VAddr addr, const u64 data) {
 void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const void* src_buffer,
                 const size_t size) {
     auto& page_table = process.vm_manager.page_table;
+    const auto address_space_lock = LockAddressSpace(process);
     size_t remaining_size = size;
     size_t page_index = dest_addr >> PAGE_BITS;
     size_t page_offset = dest_addr & PAGE_MASK;
@@ -527,7 +638,7 @@ void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const voi
         const size_t copy_amount = std::min<size_t>(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (page_table.attributes[page_index]) {
+        switch (page_table.GetAttribute(page_index)) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "unmapped WriteBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
@@ -573,10 +684,11 @@ void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const voi
 }
 
 void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size) {
-    WriteBlock(*Kernel::g_current_process, dest_addr, src_buffer, size);
+    WriteBlock(*Kernel::GetCurrentProcess(), dest_addr, src_buffer, size);
 }
 
 void ZeroBlock(const VAddr dest_addr, const size_t size) {
+    const auto address_space_lock = LockAddressSpace();
     size_t remaining_size = size;
     size_t page_index = dest_addr >> PAGE_BITS;
     size_t page_offset = dest_addr & PAGE_MASK;
@@ -587,7 +699,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
         const size_t copy_amount = std::min<size_t>(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (current_page_table->attributes[page_index]) {
+        switch (current_page_table->GetAttribute(page_index)) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory, "unmapped ZeroBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, dest_addr, size);
@@ -630,6 +742,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
 }
 
 void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
+    const auto address_space_lock = LockAddressSpace();
     size_t remaining_size = size;
     size_t page_index = src_addr >> PAGE_BITS;
     size_t page_offset = src_addr & PAGE_MASK;
@@ -638,7 +751,7 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
         const size_t copy_amount = std::min<size_t>(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (current_page_table->attributes[page_index]) {
+        switch (current_page_table->GetAttribute(page_index)) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory, "unmapped CopyBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, src_addr, size);
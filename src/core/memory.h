@@ -7,6 +7,7 @@
 #include <array>
 #include <cstddef>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <boost/optional.hpp>
@@ -28,6 +29,12 @@ const u64 PAGE_SIZE = 1 << PAGE_BITS;
 const u64 PAGE_MASK = PAGE_SIZE - 1;
 const size_t PAGE_TABLE_NUM_ENTRIES = 1ULL << (36 - PAGE_BITS);
 
+/// Number of pages covered by a directory of the page table, which amounts to 2 MiB of memory
+const size_t PAGE_DIRECTORY_BITS = 9;
+const size_t PAGE_DIRECTORY_NUM_ENTRIES = 1ULL << PAGE_DIRECTORY_BITS;
+const size_t PAGE_DIRECTORY_MASK = PAGE_DIRECTORY_NUM_ENTRIES - 1;
+const size_t PAGE_TABLE_NUM_DIRECTORIES = PAGE_TABLE_NUM_ENTRIES >> PAGE_DIRECTORY_BITS;
+
 enum class PageType {
     /// Page is unmapped and should cause an access error.
     Unmapped,
@@ -49,36 +56,78 @@ struct SpecialRegion {
     MMIORegionPointer handler;
 };
 
+/// Attributes of the pages covered by a single directory of a PageTable
+struct PageDirectory {
+    /**
+     * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
+     * the corresponding entry in `PageTable::pointers` MUST be set to null.
+     */
+    std::array<PageType, PAGE_DIRECTORY_NUM_ENTRIES> attributes{};
+
+    /**
+     * Indicates the number of externally cached resources touching a page that should be
+     * flushed before the memory is accessed
+     */
+    std::array<u8, PAGE_DIRECTORY_NUM_ENTRIES> cached_res_count{};
+};
+
 /**
  * A (reasonably) fast way of allowing switchable and remappable process address spaces. It loosely
  * mimics the way a real CPU page table works, but instead is optimized for minimal decoding and
  * fetching requirements when accessing. In the usual case of an access to regular memory, it only
  * requires an indexed fetch and a check for NULL.
+ *
+ * Only the parts of the address space which are mapped take up host memory. The pointers live in
+ * a reservation of host address space whose pages the OS commits as they are written to, and the
+ * page attributes are split into 2 MiB directories which are allocated when memory is mapped in
+ * them. Unmapping a whole directory gives both back.
  */
-struct PageTable {
-    /**
-     * Array of memory pointers backing each page. An entry can only be non-null if the
-     * corresponding entry in the `attributes` array is of type `Memory`.
-     */
-    std::array<u8*, PAGE_TABLE_NUM_ENTRIES> pointers;
+class PageTable final {
+public:
+    PageTable();
+    ~PageTable();
+
+    PageTable(const PageTable&) = delete;
+    PageTable& operator=(const PageTable&) = delete;
+
+    /// Unmaps all the pages, giving the memory used by the table back to the host
+    void Clear();
+
+    /// Returns the type of the given page
+    PageType GetAttribute(size_t page) const {
+        const PageDirectory* directory = directories[page >> PAGE_DIRECTORY_BITS].get();
+        return directory ? directory->attributes[page & PAGE_DIRECTORY_MASK] : PageType::Unmapped;
+    }
+
+    /// Returns the directory covering the given page, or nullptr if nothing was mapped in it
+    PageDirectory* FindDirectory(size_t page) {
+        return directories[page >> PAGE_DIRECTORY_BITS].get();
+    }
+
+    /// Returns the directory covering the given page, allocating it if needed
+    PageDirectory& GetDirectory(size_t page);
 
     /**
-     * Contains MMIO handlers that back memory regions whose entries in the `attribute` array is of
-     * type `Special`.
+     * Unmaps all the pages of a range of whole directories and releases their memory
+     * @param first_page First page of the range, must be the first page of a directory
+     * @param num_pages Number of pages of the range, must be a multiple of the directory size
      */
-    std::vector<SpecialRegion> special_regions;
+    void ReleaseDirectories(size_t first_page, size_t num_pages);
 
     /**
-     * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
-     * the corresponding entry in `pointers` MUST be set to null.
+     * Array of memory pointers backing each page, of PAGE_TABLE_NUM_ENTRIES entries. An entry can
+     * only be non-null if the attribute of the page is `Memory`. The array never moves, so that the
+     * JIT can look pages up in it directly.
      */
-    std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+    u8** pointers = nullptr;
 
     /**
-     * Indicates the number of externally cached resources touching a page that should be
-     * flushed before the memory is accessed
+     * Contains MMIO handlers that back memory regions whose page attributes are of type `Special`.
      */
-    std::array<u8, PAGE_TABLE_NUM_ENTRIES> cached_res_count;
+    std::vector<SpecialRegion> special_regions;
+
+private:
+    std::array<std::unique_ptr<PageDirectory>, PAGE_TABLE_NUM_DIRECTORIES> directories;
 };
 
 /// Physical memory regions as seen from the ARM11
@@ -2,10 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <chrono>
 #include <mutex>
 #include <thread>
 #include "common/math_util.h"
+#include "core/core_timing.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
 
@@ -16,6 +18,20 @@ using std::chrono::microseconds;
 
 namespace Core {
 
+void PerfStats::BeginStartup() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    startup_begin = Clock::now();
+    startup_time = Clock::duration::zero();
+    startup_pending = true;
+}
+
+PerfStats::Clock::duration PerfStats::GetStartupTime() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    return startup_time;
+}
+
 void PerfStats::BeginSystemFrame() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -37,6 +53,67 @@ void PerfStats::EndGameFrame() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
     game_frames += 1;
+
+    if (startup_pending) {
+        startup_time = Clock::now() - startup_begin;
+        startup_pending = false;
+    }
+}
+
+void PerfStats::AddFramebufferLoad(bool uploaded) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    if (uploaded) {
+        framebuffer_uploads += 1;
+    } else {
+        framebuffer_upload_skips += 1;
+    }
+}
+
+void PerfStats::AddInterpreterFallback(u32 instruction, u64 count) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    interpreter_fallbacks += count;
+    interpreter_fallback_counts[instruction] += 1;
+}
+
+void PerfStats::AddIdleSkip(u64 cycles) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    idle_skips += 1;
+    idle_skipped_cycles += cycles;
+}
+
+void PerfStats::AddSubsystemTime(Subsystem subsystem, Clock::duration time) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    subsystem_time[static_cast<size_t>(subsystem)] += time;
+}
+
+void PerfStats::AddPresentSkip() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    present_skips += 1;
+}
+
+void PerfStats::AddFrameLimiterWait(Clock::duration wakeup_error) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    frame_limiter_waits += 1;
+    frame_limiter_jitter += wakeup_error;
+    frame_limiter_max_jitter = std::max(frame_limiter_max_jitter, wakeup_error);
+}
+
+std::vector<std::pair<u32, u64>> PerfStats::GetTopInterpreterFallbacks(size_t max_entries) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    std::vector<std::pair<u32, u64>> entries(interpreter_fallback_counts.begin(),
+                                             interpreter_fallback_counts.end());
+    const size_t num_entries = std::min(max_entries, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + num_entries, entries.end(),
+                      [](const auto& a, const auto& b) { return a.second > b.second; });
+    entries.resize(num_entries);
+    return entries;
 }
 
 PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
@@ -55,6 +132,22 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second / 1'000'000.0;
+    results.interpreter_fallbacks = interpreter_fallbacks;
+    results.framebuffer_uploads = framebuffer_uploads;
+    results.framebuffer_upload_skips = framebuffer_upload_skips;
+    results.idle_skips = idle_skips;
+    results.idle_skipped_time =
+        static_cast<double>(idle_skipped_cycles) / static_cast<double>(BASE_CLOCK_RATE);
+    for (size_t i = 0; i < NUM_SUBSYSTEMS; ++i) {
+        results.subsystem_time[i] = duration_cast<DoubleSecs>(subsystem_time[i]).count();
+    }
+    results.present_skips = present_skips;
+    results.frame_limiter_waits = frame_limiter_waits;
+    if (frame_limiter_waits != 0) {
+        results.frame_limiter_jitter =
+            duration_cast<DoubleSecs>(frame_limiter_jitter).count() / frame_limiter_waits;
+    }
+    results.frame_limiter_max_jitter = duration_cast<DoubleSecs>(frame_limiter_max_jitter).count();
 
     // Reset counters
     reset_point = now;
@@ -62,6 +155,16 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    interpreter_fallbacks = 0;
+    framebuffer_uploads = 0;
+    framebuffer_upload_skips = 0;
+    idle_skips = 0;
+    idle_skipped_cycles = 0;
+    subsystem_time.fill(Clock::duration::zero());
+    present_skips = 0;
+    frame_limiter_waits = 0;
+    frame_limiter_jitter = Clock::duration::zero();
+    frame_limiter_max_jitter = Clock::duration::zero();
 
     return results;
 }
@@ -73,32 +176,47 @@ double PerfStats::GetLastFrameTimeScale() {
     return duration_cast<DoubleSecs>(previous_frame_length).count() / FRAME_LENGTH;
 }
 
-void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
+boost::optional<FrameLimiter::Clock::duration> FrameLimiter::DoFrameLimiting(
+    u64 current_system_time_us) {
     // Max lag caused by slow frames. Can be adjusted to compensate for too many slow frames. Higher
     // values increase the time needed to recover and limit framerate again after spikes.
     constexpr microseconds MAX_LAG_TIME_US = 25ms;
+    // Remaining wait below which the limiter spins instead of sleeping
+    constexpr microseconds SPIN_TIME_US = 2ms;
 
-    if (!Settings::values.toggle_framelimit) {
-        return;
+    if (!Settings::values.toggle_framelimit || Settings::values.frame_limit == 0) {
+        return boost::none;
     }
 
     auto now = Clock::now();
 
-    frame_limiting_delta_err += microseconds(current_system_time_us - previous_system_time_us);
+    const u64 system_time_elapsed_us =
+        (current_system_time_us - previous_system_time_us) * 100 / Settings::values.frame_limit;
+    frame_limiting_delta_err += microseconds(system_time_elapsed_us);
     frame_limiting_delta_err -= duration_cast<microseconds>(now - previous_walltime);
     frame_limiting_delta_err =
         MathUtil::Clamp(frame_limiting_delta_err, -MAX_LAG_TIME_US, MAX_LAG_TIME_US);
 
-    if (frame_limiting_delta_err > microseconds::zero()) {
-        std::this_thread::sleep_for(frame_limiting_delta_err);
+    previous_system_time_us = current_system_time_us;
 
-        auto now_after_sleep = Clock::now();
-        frame_limiting_delta_err -= duration_cast<microseconds>(now_after_sleep - now);
-        now = now_after_sleep;
+    if (frame_limiting_delta_err <= microseconds::zero()) {
+        previous_walltime = now;
+        return boost::none;
     }
 
-    previous_system_time_us = current_system_time_us;
-    previous_walltime = now;
+    const auto target = now + frame_limiting_delta_err;
+    if (frame_limiting_delta_err > SPIN_TIME_US) {
+        std::this_thread::sleep_for(frame_limiting_delta_err - SPIN_TIME_US);
+    }
+    auto now_after_wait = Clock::now();
+    while (now_after_wait < target) {
+        std::this_thread::yield();
+        now_after_wait = Clock::now();
+    }
+
+    frame_limiting_delta_err -= duration_cast<microseconds>(now_after_wait - now);
+    previous_walltime = now_after_wait;
+    return now_after_wait - target;
 }
 
 } // namespace Core
@@ -4,8 +4,13 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 
 namespace Core {
@@ -18,6 +23,17 @@ class PerfStats {
 public:
     using Clock = std::chrono::high_resolution_clock;
 
+    /**
+     * Host subsystems whose walltime is tracked. Services run from SVCs, so their time is also part
+     * of the CPU time.
+     */
+    enum class Subsystem {
+        Cpu,      ///< Guest code execution, including the SVCs it makes
+        Services, ///< HLE service request handling
+        Video,    ///< Loading and presenting framebuffers, excluding frame limiting
+    };
+    static constexpr size_t NUM_SUBSYSTEMS = 3;
+
     struct Results {
         /// System FPS (LCD VBlanks) in Hz
         double system_fps;
@@ -27,12 +43,79 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Number of instructions handed to the interpreter fallback since last reset
+        u64 interpreter_fallbacks;
+        /// Number of flipped framebuffers that were copied to the host since last reset
+        u32 framebuffer_uploads;
+        /// Number of flipped framebuffers whose upload was skipped as unchanged since last reset
+        u32 framebuffer_upload_skips;
+        /// Number of busy-waits which were skipped since last reset
+        u32 idle_skips;
+        /// Emulated time skipped over by busy-waits since last reset, in seconds
+        double idle_skipped_time;
+        /// Walltime spent in each Subsystem since last reset, in seconds
+        std::array<double, NUM_SUBSYSTEMS> subsystem_time;
+        /// Number of system frames without a new framebuffer, not presented on the host
+        u32 present_skips;
+        /// Number of times the frame limiter waited since last reset
+        u32 frame_limiter_waits;
+        /// Average difference between the time the frame limiter woke up and its target, in seconds
+        double frame_limiter_jitter;
+        /// Largest difference between the time the frame limiter woke up and its target, in seconds
+        double frame_limiter_max_jitter;
     };
 
+    /// Marks the point at which the emulated application started loading
+    void BeginStartup();
+
+    /**
+     * Gets the walltime between the application starting to load and presenting its first frame.
+     * @returns The startup time, or zero if no frame has been presented since BeginStartup
+     */
+    Clock::duration GetStartupTime();
+
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /**
+     * Records that a flipped framebuffer was loaded by the renderer
+     * @param uploaded Whether the contents had to be copied, or were unchanged since the last load
+     */
+    void AddFramebufferLoad(bool uploaded);
+
+    /**
+     * Records that the JIT had to fall back to the interpreter to execute an instruction.
+     * @param instruction The instruction word the JIT could not handle
+     * @param count Number of instructions that were interpreted as part of the fallback
+     */
+    void AddInterpreterFallback(u32 instruction, u64 count);
+
+    /**
+     * Records that a guest thread busy-waiting for time to pass was fast-forwarded.
+     * @param cycles Number of emulated CPU cycles that were skipped
+     */
+    void AddIdleSkip(u64 cycles);
+
+    /// Records walltime spent in one of the tracked host subsystems
+    void AddSubsystemTime(Subsystem subsystem, Clock::duration time);
+
+    /// Records that a system frame was not presented on the host, as nothing changed
+    void AddPresentSkip();
+
+    /**
+     * Records a wait of the frame limiter
+     * @param wakeup_error How long after its target time the frame limiter woke up
+     */
+    void AddFrameLimiterWait(Clock::duration wakeup_error);
+
+    /**
+     * Gets the instruction words that most frequently required an interpreter fallback during this
+     * emulation session, along with their fallback counts, in descending order.
+     * @param max_entries Maximum number of entries to return
+     */
+    std::vector<std::pair<u32, u64>> GetTopInterpreterFallbacks(size_t max_entries);
+
     Results GetAndResetStats(u64 current_system_time_us);
 
     /**
@@ -55,6 +138,36 @@ private:
     u32 system_frames = 0;
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
+    /// Cumulative number of interpreted instructions since last reset
+    u64 interpreter_fallbacks = 0;
+    /// Cumulative number of framebuffers copied to the host since last reset
+    u32 framebuffer_uploads = 0;
+    /// Cumulative number of unchanged framebuffers that were not copied since last reset
+    u32 framebuffer_upload_skips = 0;
+    /// Cumulative number of skipped busy-waits since last reset
+    u32 idle_skips = 0;
+    /// Cumulative number of emulated CPU cycles skipped by busy-waits since last reset
+    u64 idle_skipped_cycles = 0;
+    /// Cumulative walltime spent in each Subsystem since last reset
+    std::array<Clock::duration, NUM_SUBSYSTEMS> subsystem_time{};
+    /// Cumulative number of system frames not presented on the host since last reset
+    u32 present_skips = 0;
+    /// Cumulative number of frame limiter waits since last reset
+    u32 frame_limiter_waits = 0;
+    /// Cumulative wakeup error of the frame limiter since last reset
+    Clock::duration frame_limiter_jitter = Clock::duration::zero();
+    /// Largest wakeup error of the frame limiter since last reset
+    Clock::duration frame_limiter_max_jitter = Clock::duration::zero();
+
+    /// Number of interpreter fallbacks per instruction word, kept for the whole session
+    std::unordered_map<u32, u64> interpreter_fallback_counts;
+
+    /// Point when the emulated application started loading
+    Clock::time_point startup_begin = reset_point;
+    /// Time it took the emulated application to present its first frame
+    Clock::duration startup_time = Clock::duration::zero();
+    /// Whether the first game frame since BeginStartup is still outstanding
+    bool startup_pending = false;
 
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
@@ -64,11 +177,21 @@ private:
     Clock::duration previous_frame_length = Clock::duration::zero();
 };
 
+/**
+ * Keeps the emulated time from running ahead of walltime, scaled by the speed limit in the
+ * settings. Waits sleep for most of their duration and then spin until the target time, as the OS
+ * scheduler may oversleep by a millisecond or more.
+ */
 class FrameLimiter {
 public:
     using Clock = std::chrono::high_resolution_clock;
 
-    void DoFrameLimiting(u64 current_system_time_us);
+    /**
+     * Waits until walltime has caught up with the emulated time
+     * @param current_system_time_us Emulated time at the end of the frame
+     * @returns How late the limiter woke up compared to its target time, or none if it didn't wait
+     */
+    boost::optional<Clock::duration> DoFrameLimiting(u64 current_system_time_us);
 
 private:
     /// Emulated system time (in microseconds) at the last limiter invocation
@@ -109,6 +109,11 @@ enum class CpuCore {
     Dynarmic,
 };
 
+enum class RendererBackend {
+    OpenGL,
+    Null,
+};
+
 struct Values {
     // Controls
     std::array<std::string, NativeButton::NumButtons> buttons;
@@ -118,13 +123,17 @@ struct Values {
 
     // Core
     CpuCore cpu_core;
+    bool use_multi_core;
 
     // Data Storage
     bool use_virtual_sd;
 
     // Renderer
+    RendererBackend renderer_backend;
     float resolution_factor;
     bool toggle_framelimit;
+    u16 frame_limit; ///< Emulation speed targeted by the frame limiter, in percent
+    bool use_asynchronous_gpu_emulation;
 
     float bg_red;
     float bg_green;
@@ -0,0 +1,239 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_types.h"
+#include "common/thread_queue_list.h"
+
+namespace Common {
+
+namespace {
+
+struct FakeThread {
+    u32 id;
+    u32 priority;
+    ThreadQueueListNode<FakeThread> node;
+    VAddr wait_address;
+    ThreadQueueListNode<FakeThread> arbitration_node;
+};
+
+constexpr unsigned int NUM_PRIORITIES = 64;
+using FakeQueue = ThreadQueueList<FakeThread, NUM_PRIORITIES, &FakeThread::node>;
+using FakeArbitrationQueue =
+    KeyedThreadQueueList<VAddr, FakeThread, NUM_PRIORITIES, &FakeThread::arbitration_node>;
+
+} // Anonymous namespace
+
+TEST_CASE("ThreadQueueList::Order", "[common]") {
+    FakeQueue queue;
+    std::vector<FakeThread> threads(4);
+    for (u32 i = 0; i < threads.size(); ++i) {
+        threads[i].id = i;
+    }
+
+    REQUIRE(queue.get_first() == nullptr);
+    REQUIRE(queue.pop_first() == nullptr);
+
+    queue.push_back(40, &threads[0]);
+    queue.push_back(10, &threads[1]);
+    queue.push_back(10, &threads[2]);
+    queue.push_front(10, &threads[3]);
+    REQUIRE(queue.contains(&threads[0]) == 40);
+    REQUIRE(!queue.empty(10));
+    REQUIRE(queue.empty(11));
+
+    // Strictly better priorities only
+    REQUIRE(queue.pop_first_better(10) == nullptr);
+    REQUIRE(queue.get_first() == &threads[3]);
+
+    queue.rotate(10);
+    REQUIRE(queue.pop_first_better(11) == &threads[1]);
+    REQUIRE(queue.pop_first() == &threads[2]);
+    REQUIRE(queue.pop_first() == &threads[3]);
+    REQUIRE(queue.empty(10));
+    REQUIRE(queue.contains(&threads[3]) == static_cast<FakeQueue::Priority>(-1));
+
+    queue.move(&threads[0], 40, 63);
+    REQUIRE(queue.empty(40));
+    REQUIRE(queue.contains(&threads[0]) == 63);
+
+    // Removing an element which isn't queued is allowed
+    queue.remove(63, &threads[1]);
+    queue.remove(63, &threads[0]);
+    REQUIRE(queue.get_first() == nullptr);
+}
+
+TEST_CASE("ThreadQueueList::RemoveFromMiddle", "[common]") {
+    FakeQueue queue;
+    std::vector<FakeThread> threads(3);
+
+    for (auto& thread : threads) {
+        queue.push_back(0, &thread);
+    }
+    queue.remove(0, &threads[1]);
+    REQUIRE(queue.pop_first() == &threads[0]);
+    REQUIRE(queue.pop_first() == &threads[2]);
+    REQUIRE(queue.pop_first() == nullptr);
+
+    for (auto& thread : threads) {
+        queue.push_back(5, &thread);
+    }
+    queue.clear();
+    REQUIRE(queue.get_first() == nullptr);
+    for (const auto& thread : threads) {
+        REQUIRE(!thread.node.queued);
+    }
+}
+
+TEST_CASE("ThreadQueueList::Benchmark", "[.benchmark]") {
+    constexpr u32 num_threads = 4096;
+    constexpr u32 iterations = 1000000;
+
+    FakeQueue queue;
+    std::vector<FakeThread> threads(num_threads);
+    std::mt19937 rng(0x5EED);
+    for (u32 i = 0; i < num_threads; ++i) {
+        threads[i].id = i;
+        threads[i].priority = rng() % NUM_PRIORITIES;
+        queue.push_back(threads[i].priority, &threads[i]);
+    }
+
+    // Mimics a scheduler: the best thread runs, then either yields or gets its priority changed
+    // while some other ready thread is moved around or unscheduled and rescheduled.
+    u64 checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; ++i) {
+        FakeThread* running = queue.pop_first();
+        checksum += running->id;
+
+        FakeThread& other = threads[rng() % num_threads];
+        if (other.node.queued) {
+            const u32 new_priority = rng() % NUM_PRIORITIES;
+            queue.move(&other, other.priority, new_priority);
+            other.priority = new_priority;
+        }
+
+        queue.push_back(running->priority, running);
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    REQUIRE(checksum != 0);
+    std::printf("Scheduler iteration with %u threads: %.1f ns\n", num_threads,
+                elapsed.count() / iterations);
+}
+
+TEST_CASE("KeyedThreadQueueList::Arbitration", "[common]") {
+    // Worker pool waiting on a handful of addresses: threads wait, time out, get boosted while
+    // waiting and are signaled.
+    constexpr u32 num_threads = 256;
+    constexpr u32 num_addresses = 8;
+    constexpr VAddr base_address = 0x10000000;
+
+    FakeArbitrationQueue queue;
+    std::vector<FakeThread> threads(num_threads);
+    for (u32 i = 0; i < num_threads; ++i) {
+        threads[i].id = i;
+        threads[i].priority = 63 - (i / num_addresses) % 4;
+        threads[i].wait_address = base_address + (i % num_addresses) * 4;
+        queue.push_back(threads[i].wait_address, threads[i].priority, &threads[i]);
+    }
+
+    const VAddr first_address = base_address;
+    REQUIRE(queue.pop_first(base_address + num_addresses * 4) == nullptr);
+
+    // Signal one: the best priority goes first, in FIFO order among equals
+    FakeThread* signaled = queue.pop_first(first_address);
+    REQUIRE(signaled->priority == 60);
+    REQUIRE(signaled->id == 24);
+    REQUIRE(queue.pop_first(first_address)->id == 56);
+
+    // A waiter which times out leaves the queue, removing it again does nothing
+    FakeThread& timed_out = threads[88];
+    REQUIRE(timed_out.wait_address == first_address);
+    queue.remove(timed_out.wait_address, timed_out.priority, &timed_out);
+    queue.remove(timed_out.wait_address, timed_out.priority, &timed_out);
+
+    // Priority inheritance boosts a waiter past all the others
+    FakeThread& boosted = threads[248];
+    queue.move(boosted.wait_address, &boosted, boosted.priority, 10);
+    boosted.priority = 10;
+    REQUIRE(queue.pop_first(first_address) == &boosted);
+
+    // Moving a thread which isn't waiting anymore leaves it alone
+    queue.move(boosted.wait_address, &boosted, boosted.priority, 20);
+    REQUIRE(!boosted.arbitration_node.queued);
+
+    // Signal all: every remaining waiter of the address comes out ordered by priority
+    u32 woken = 0;
+    u32 last_priority = 0;
+    while (FakeThread* thread = queue.pop_first(first_address)) {
+        REQUIRE(thread->wait_address == first_address);
+        REQUIRE(thread->priority >= last_priority);
+        last_priority = thread->priority;
+        ++woken;
+    }
+    REQUIRE(woken == num_threads / num_addresses - 4);
+    REQUIRE(queue.empty(first_address));
+
+    // The other addresses were left untouched
+    REQUIRE(!queue.empty(base_address + 4));
+
+    // A key whose only waiter leaves is freed, and can be waited on again afterwards
+    const VAddr lone_address = base_address + num_addresses * 4;
+    FakeThread& lone = threads[0];
+    REQUIRE(!lone.arbitration_node.queued);
+    queue.push_back(lone_address, lone.priority, &lone);
+    queue.remove(lone_address, lone.priority, &lone);
+    REQUIRE(queue.empty(lone_address));
+    queue.push_back(lone_address, lone.priority, &lone);
+    REQUIRE(queue.pop_first(lone_address) == &lone);
+    REQUIRE(queue.empty(lone_address));
+
+    queue.clear();
+    REQUIRE(queue.empty(base_address + 4));
+    REQUIRE(!threads[1].arbitration_node.queued);
+}
+
+TEST_CASE("KeyedThreadQueueList::Benchmark", "[.benchmark]") {
+    constexpr u32 num_threads = 4096;
+    constexpr u32 num_addresses = 64;
+    constexpr u32 iterations = 1000000;
+    constexpr VAddr base_address = 0x10000000;
+
+    FakeArbitrationQueue queue;
+    std::vector<FakeThread> threads(num_threads);
+    std::mt19937 rng(0x5EED);
+    for (u32 i = 0; i < num_threads; ++i) {
+        threads[i].id = i;
+        threads[i].priority = rng() % NUM_PRIORITIES;
+        threads[i].wait_address = base_address + (rng() % num_addresses) * 4;
+        queue.push_back(threads[i].wait_address, threads[i].priority, &threads[i]);
+    }
+
+    // Signals a random condition variable, the woken thread then waits on another one
+    u64 checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; ++i) {
+        FakeThread* thread = queue.pop_first(base_address + (rng() % num_addresses) * 4);
+        if (thread == nullptr) {
+            continue;
+        }
+        checksum += thread->id;
+        thread->wait_address = base_address + (rng() % num_addresses) * 4;
+        queue.push_back(thread->wait_address, thread->priority, thread);
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    REQUIRE(checksum != 0);
+    std::printf("Signal with %u waiters on %u addresses: %.1f ns\n", num_threads, num_addresses,
+                elapsed.count() / iterations);
+}
+
+} // namespace Common
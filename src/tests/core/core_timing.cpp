@@ -5,8 +5,13 @@
 #include <catch.hpp>
 
 #include <array>
+#include <atomic>
 #include <bitset>
+#include <chrono>
+#include <cstdio>
 #include <string>
+#include <thread>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -235,3 +240,138 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
 }
+
+TEST_CASE("CoreTiming[UnscheduleByHandle]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+    CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", CallbackTemplate<1>);
+    CoreTiming::EventType* cb_c = CoreTiming::RegisterEvent("callbackC", CallbackTemplate<2>);
+    CoreTiming::EventType* cb_d = CoreTiming::RegisterEvent("callbackD", CallbackTemplate<3>);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    const CoreTiming::EventHandle handle_a = CoreTiming::ScheduleEvent(100, cb_a, CB_IDS[0]);
+    CoreTiming::ScheduleEvent(200, cb_b, CB_IDS[1]);
+    const CoreTiming::EventHandle handle_c = CoreTiming::ScheduleEvent(300, cb_c, CB_IDS[2]);
+    CoreTiming::ScheduleEvent(400, cb_d, CB_IDS[3]);
+
+    // Removing the front and a middle event must leave the rest in order
+    CoreTiming::UnscheduleEvent(handle_a);
+    CoreTiming::UnscheduleEvent(handle_c);
+
+    AdvanceAndCheck(1, 200, 0, -100);
+    AdvanceAndCheck(3, MAX_SLICE_LENGTH);
+
+    // Handles of events that already fired or were unscheduled are ignored, even once their
+    // slots have been reused by new events
+    const CoreTiming::EventHandle handle_b = CoreTiming::ScheduleEvent(100, cb_b, CB_IDS[1]);
+    CoreTiming::UnscheduleEvent(handle_a);
+    CoreTiming::UnscheduleEvent(handle_c);
+    CoreTiming::UnscheduleEvent(CoreTiming::INVALID_EVENT_HANDLE);
+    REQUIRE(handle_b != handle_a);
+    REQUIRE(handle_b != handle_c);
+    AdvanceAndCheck(1, MAX_SLICE_LENGTH);
+}
+
+namespace ContentionTest {
+static std::atomic<u64> callbacks_ran{0};
+
+static void CountingCallback(u64 userdata, s64 cycles_late) {
+    ++callbacks_ran;
+}
+} // namespace ContentionTest
+
+TEST_CASE("CoreTiming[ThreadsafeContention]", "[core]") {
+    using namespace ContentionTest;
+
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb = CoreTiming::RegisterEvent("callbackCount", CountingCallback);
+    callbacks_ran = 0;
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    constexpr int num_producers = 4;
+    constexpr int events_per_producer = 10000;
+    std::atomic<int> producers_done{0};
+    std::vector<std::thread> producers;
+    for (int i = 0; i < num_producers; ++i) {
+        producers.emplace_back([&] {
+            for (int event = 0; event < events_per_producer; ++event) {
+                CoreTiming::ScheduleEventThreadsafe(0, cb, static_cast<u64>(event));
+            }
+            ++producers_done;
+        });
+    }
+
+    // Keep draining the inbox while the producers are still pushing
+    while (producers_done != num_producers) {
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    CoreTiming::AddTicks(CoreTiming::GetDowncount());
+    CoreTiming::Advance();
+
+    REQUIRE(callbacks_ran == num_producers * events_per_producer);
+}
+
+TEST_CASE("CoreTiming[Benchmark]", "[.benchmark]") {
+    using namespace ContentionTest;
+    using Clock = std::chrono::steady_clock;
+
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb = CoreTiming::RegisterEvent("callbackCount", CountingCallback);
+    callbacks_ran = 0;
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    // Schedule and unschedule through handles, with a large number of other events pending
+    constexpr int num_events = 1000000;
+    std::vector<CoreTiming::EventHandle> handles(num_events);
+    auto start = Clock::now();
+    for (u64 i = 0; i < num_events; ++i) {
+        handles[i] = CoreTiming::ScheduleEvent(MAX_SLICE_LENGTH + (i * 7919) % 100000, cb, i);
+    }
+    for (u64 i = 0; i < num_events; ++i) {
+        CoreTiming::UnscheduleEvent(handles[(i * 7919) % num_events]);
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("schedule/unschedule: %.1f Mops/s\n", 2 * num_events / elapsed / 1e6);
+    REQUIRE(callbacks_ran == 0);
+
+    // Schedule from several threads at once while the emu thread drains the inbox
+    constexpr int num_producers = 4;
+    constexpr int events_per_producer = 250000;
+    std::atomic<int> producers_done{0};
+    std::vector<std::thread> producers;
+    start = Clock::now();
+    for (int i = 0; i < num_producers; ++i) {
+        producers.emplace_back([&] {
+            for (int event = 0; event < events_per_producer; ++event) {
+                CoreTiming::ScheduleEventThreadsafe(0, cb, static_cast<u64>(event));
+            }
+            ++producers_done;
+        });
+    }
+    while (producers_done != num_producers) {
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    CoreTiming::AddTicks(CoreTiming::GetDowncount());
+    CoreTiming::Advance();
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("threadsafe schedule with %d producers: %.1f Mops/s\n", num_producers,
+                num_producers * events_per_producer / elapsed / 1e6);
+    REQUIRE(callbacks_ran == num_producers * events_per_producer);
+}
@@ -0,0 +1,133 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/thread.h"
+
+namespace Kernel {
+
+TEST_CASE("HandleTable::Generations", "[core][kernel]") {
+    HandleTable table;
+    auto process = Process::Create("");
+
+    const Handle handle = table.Create(process).Unwrap();
+    REQUIRE(table.IsValid(handle));
+    REQUIRE(table.Get<Process>(handle) == process);
+    {
+        HandleTable::ReadGuard guard(table);
+        REQUIRE(table.Lookup<Process>(handle) == process.get());
+        REQUIRE(table.Lookup<Thread>(handle) == nullptr);
+    }
+
+    REQUIRE(table.Close(handle) == RESULT_SUCCESS);
+    REQUIRE(!table.IsValid(handle));
+    REQUIRE(table.GetGeneric(handle) == nullptr);
+    REQUIRE(table.Close(handle) != RESULT_SUCCESS);
+
+    // The slot is reused with a new generation, the stale handle stays invalid
+    const Handle reused = table.Create(process).Unwrap();
+    REQUIRE(reused >> 15 == handle >> 15);
+    REQUIRE(reused != handle);
+    REQUIRE(!table.IsValid(handle));
+    REQUIRE(table.IsValid(reused));
+
+    table.Clear();
+    REQUIRE(!table.IsValid(reused));
+}
+
+TEST_CASE("HandleTable::Growth", "[core][kernel]") {
+    HandleTable table;
+    auto process = Process::Create("");
+
+    // More than the 4096 handles of the previous fixed size table
+    std::vector<Handle> handles;
+    for (int i = 0; i < 10000; ++i) {
+        handles.push_back(table.Create(process).Unwrap());
+    }
+    for (Handle handle : handles) {
+        REQUIRE(table.GetGeneric(handle) == process);
+    }
+    for (Handle handle : handles) {
+        REQUIRE(table.Close(handle) == RESULT_SUCCESS);
+    }
+    REQUIRE(!table.IsValid(handles.back()));
+}
+
+TEST_CASE("HandleTable::ConcurrentLookups", "[core][kernel]") {
+    HandleTable table;
+    auto process = Process::Create("");
+    auto churned_process = Process::Create("");
+    const Handle stable_handle = table.Create(process).Unwrap();
+
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&] {
+            while (!done) {
+                HandleTable::ReadGuard guard(table);
+                if (table.Lookup(stable_handle) != process.get()) {
+                    ++failures;
+                }
+            }
+        });
+    }
+
+    // Churn the handles, growing the table and retiring objects under the readers
+    for (int round = 0; round < 20; ++round) {
+        std::vector<Handle> handles;
+        for (int i = 0; i < 2000; ++i) {
+            handles.push_back(table.Create(churned_process).Unwrap());
+        }
+        for (Handle handle : handles) {
+            table.Close(handle);
+        }
+    }
+
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    REQUIRE(failures == 0);
+    REQUIRE(table.GetGeneric(stable_handle) == process);
+}
+
+TEST_CASE("HandleTable::ReaderIndicesAreRecycled", "[core][kernel]") {
+    HandleTable table;
+    auto process = Process::Create("");
+    const Handle handle = table.Create(process).Unwrap();
+
+    // Far more short-lived reader threads than there are reader indices
+    for (int i = 0; i < 64; ++i) {
+        std::thread([&] {
+            HandleTable::ReadGuard guard(table);
+            table.Lookup(handle);
+        }).join();
+    }
+
+    // A reader which got an index doesn't hold the table's mutex, so handles can still be closed
+    // while it is inside its guard
+    std::atomic<bool> guard_taken{false};
+    std::atomic<bool> closed{false};
+    std::thread reader([&] {
+        HandleTable::ReadGuard guard(table);
+        guard_taken = true;
+        while (!closed) {
+            std::this_thread::yield();
+        }
+    });
+    while (!guard_taken) {
+        std::this_thread::yield();
+    }
+    REQUIRE(table.Close(handle) == RESULT_SUCCESS);
+    closed = true;
+    reader.join();
+}
+
+} // namespace Kernel
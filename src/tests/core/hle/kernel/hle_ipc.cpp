@@ -0,0 +1,179 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <tuple>
+#include <catch.hpp>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/hle/ipc.h"
+#include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/server_session.h"
+
+namespace {
+
+using CommandBuffer = std::array<u32, IPC::COMMAND_BUFFER_LENGTH>;
+
+constexpr u32 TEST_COMMAND = 42;
+
+/// Writes a request with the given command id and raw parameters, as a guest would
+void WriteRequest(CommandBuffer& cmdbuf, u32 command, std::initializer_list<u32> params) {
+    cmdbuf.fill(0);
+    IPC::RequestBuilder rb{cmdbuf.data()};
+
+    IPC::CommandHeader header{};
+    header.type.Assign(IPC::CommandType::Request);
+    // Payload header, 16 bytes of padding, the u64 command id and the parameters
+    header.data_size.Assign(sizeof(IPC::DataPayloadHeader) / 4 + 4 + 2 +
+                            static_cast<u32>(params.size()));
+    rb.PushRaw(header);
+    rb.AlignWithPadding();
+
+    IPC::DataPayloadHeader data_payload_header{};
+    data_payload_header.magic = Common::MakeMagic('S', 'F', 'C', 'I');
+    rb.PushRaw(data_payload_header);
+    rb.Push<u64>(command);
+    for (u32 param : params) {
+        rb.Push(param);
+    }
+}
+
+/// Writes a request with the given command id and a single u64 parameter
+void WriteRequest(CommandBuffer& cmdbuf, u32 command, u64 param) {
+    WriteRequest(cmdbuf, command, {static_cast<u32>(param), static_cast<u32>(param >> 32)});
+}
+
+/// Handles a request the same way ServiceFramework does, echoing the parameter back
+u64 RoundTrip(CommandBuffer& cmdbuf, Kernel::SharedPtr<Kernel::ServerSession> session,
+              Kernel::Process& process) {
+    Kernel::HLERequestContext context(std::move(session));
+    context.PopulateFromIncomingCommandBuffer(cmdbuf.data(), process, Kernel::g_handle_table);
+
+    IPC::RequestParser rp{context};
+    const u64 param = rp.Pop<u64>();
+
+    IPC::RequestBuilder rb{context, 4};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push(param);
+
+    context.WriteToOutgoingCommandBuffer(cmdbuf.data(), process, Kernel::g_handle_table);
+    return param;
+}
+
+/// Handler whose parameters need padding on both the request and the response
+struct MarshalledService {
+    ResultCode Handler(u32 a, u64 b, bool c, u64& sum, u32& flag) {
+        sum = a + b;
+        flag = c ? 0xF1A6 : 0;
+        return RESULT_SUCCESS;
+    }
+
+    ResultCode Fail(u32 a, u64& out) {
+        out = a;
+        return ResultCode(-1);
+    }
+};
+
+} // Anonymous namespace
+
+TEST_CASE("HLERequestContext::InPlaceRoundTrip", "[core][kernel]") {
+    auto session = std::get<Kernel::SharedPtr<Kernel::ServerSession>>(
+        Kernel::ServerSession::CreateSessionPair("Test", nullptr));
+    auto process = Kernel::Process::Create("");
+
+    CommandBuffer cmdbuf;
+    WriteRequest(cmdbuf, TEST_COMMAND, 0x1122334455667788);
+
+    Kernel::HLERequestContext context(session);
+    context.PopulateFromIncomingCommandBuffer(cmdbuf.data(), *process, Kernel::g_handle_table);
+    REQUIRE(context.CommandBuffer() == cmdbuf.data());
+    REQUIRE(context.GetCommandType() == IPC::CommandType::Request);
+    REQUIRE(context.GetCommand() == TEST_COMMAND);
+    REQUIRE(context.BufferDescriptorX().empty());
+    REQUIRE(!context.GetDomainMessageHeader());
+
+    REQUIRE(RoundTrip(cmdbuf, session, *process) == 0x1122334455667788);
+
+    // The response replaced the request: header, padding, payload header, result and the value
+    IPC::RequestParser response{cmdbuf.data()};
+    const auto header = response.PopRaw<IPC::CommandHeader>();
+    REQUIRE(header.enable_handle_descriptor == 0);
+    response.AlignWithPadding();
+    REQUIRE(response.PopRaw<IPC::DataPayloadHeader>().magic ==
+            Common::MakeMagic('S', 'F', 'C', 'O'));
+    REQUIRE(response.Pop<ResultCode>() == RESULT_SUCCESS);
+    response.Skip(1, false);
+    REQUIRE(response.Pop<u64>() == 0x1122334455667788);
+}
+
+TEST_CASE("IPC::InvokeMarshalled", "[core][kernel]") {
+    auto session = std::get<Kernel::SharedPtr<Kernel::ServerSession>>(
+        Kernel::ServerSession::CreateSessionPair("Test", nullptr));
+    auto process = Kernel::Process::Create("");
+    MarshalledService service;
+    CommandBuffer cmdbuf;
+
+    const auto invoke = [&](auto handler) {
+        Kernel::HLERequestContext context(session);
+        context.PopulateFromIncomingCommandBuffer(cmdbuf.data(), *process, Kernel::g_handle_table);
+        IPC::InvokeMarshalled(&service, handler, context);
+        context.WriteToOutgoingCommandBuffer(cmdbuf.data(), *process, Kernel::g_handle_table);
+
+        IPC::RequestParser response{cmdbuf.data()};
+        const auto header = response.PopRaw<IPC::CommandHeader>();
+        response.AlignWithPadding();
+        response.Skip(sizeof(IPC::DataPayloadHeader) / 4, false);
+        return std::make_tuple(header.data_size.Value(), response);
+    };
+
+    SECTION("u64 parameters are 8-byte aligned") {
+        // a, padding, b, c
+        WriteRequest(cmdbuf, TEST_COMMAND, {0x10, 0xDEAD, 0x20, 0x1, 0x1, 0x0});
+        auto [data_size, response] = invoke(&MarshalledService::Handler);
+
+        // Payload header, padding, result and the outputs
+        REQUIRE(data_size == sizeof(IPC::DataPayloadHeader) / 4 + 4 + 2 + 3);
+        REQUIRE(response.Pop<ResultCode>() == RESULT_SUCCESS);
+        response.Skip(1, false);
+        REQUIRE(response.Pop<u64>() == 0x100000030);
+        REQUIRE(response.Pop<u32>() == 0xF1A6);
+    }
+
+    SECTION("Errors only send back the result") {
+        WriteRequest(cmdbuf, TEST_COMMAND, {0x10});
+        auto [data_size, response] = invoke(&MarshalledService::Fail);
+
+        REQUIRE(data_size == sizeof(IPC::DataPayloadHeader) / 4 + 4 + 2);
+        REQUIRE(response.Pop<ResultCode>() == ResultCode(-1));
+    }
+}
+
+TEST_CASE("HLERequestContext::Benchmark", "[.benchmark]") {
+    auto session = std::get<Kernel::SharedPtr<Kernel::ServerSession>>(
+        Kernel::ServerSession::CreateSessionPair("Test", nullptr));
+    auto process = Kernel::Process::Create("");
+
+    constexpr u64 iterations = 1000000;
+    CommandBuffer cmdbuf;
+    u64 checksum = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (u64 i = 0; i < iterations; ++i) {
+        WriteRequest(cmdbuf, TEST_COMMAND, i);
+        checksum += RoundTrip(cmdbuf, session, *process);
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    REQUIRE(checksum == iterations * (iterations - 1) / 2);
+    std::printf("IPC round trip: %.1f ns\n", elapsed.count() / iterations);
+}
@@ -0,0 +1,129 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "core/hle/kernel/vm_manager.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+TEST_CASE("VMManager::MapReprotectUnmap", "[core][kernel]") {
+    constexpr u64 num_pages = 16;
+    constexpr VAddr base = Memory::HEAP_VADDR;
+    const size_t base_page = base >> Memory::PAGE_BITS;
+
+    auto vm_manager = std::make_unique<VMManager>();
+    auto block = std::make_shared<std::vector<u8>>(num_pages * Memory::PAGE_SIZE);
+    auto& page_table = vm_manager->page_table;
+
+    REQUIRE(vm_manager
+                ->MapMemoryBlock(base, block, 0, num_pages * Memory::PAGE_SIZE, MemoryState::Heap)
+                .Succeeded());
+    REQUIRE(page_table.GetAttribute(base_page) == Memory::PageType::Memory);
+    REQUIRE(page_table.pointers[base_page] == block->data());
+    REQUIRE(page_table.pointers[base_page + num_pages - 1] ==
+            block->data() + (num_pages - 1) * Memory::PAGE_SIZE);
+    REQUIRE(page_table.GetAttribute(base_page + num_pages) == Memory::PageType::Unmapped);
+
+    // The lookup of an address inside of the block finds it, however often it is repeated
+    for (int i = 0; i < 2; ++i) {
+        const auto vma = vm_manager->FindVMA(base + 5 * Memory::PAGE_SIZE);
+        REQUIRE(vma->second.base == base);
+        REQUIRE(vma->second.size == num_pages * Memory::PAGE_SIZE);
+    }
+
+    // Reprotecting part of the block splits it without touching the mappings
+    const VAddr middle = base + 4 * Memory::PAGE_SIZE;
+    REQUIRE(vm_manager->ReprotectRange(middle, 4 * Memory::PAGE_SIZE, VMAPermission::Read) ==
+            RESULT_SUCCESS);
+    auto vma = vm_manager->FindVMA(middle + Memory::PAGE_SIZE);
+    REQUIRE(vma->second.base == middle);
+    REQUIRE(vma->second.size == 4 * Memory::PAGE_SIZE);
+    REQUIRE(vma->second.permissions == VMAPermission::Read);
+    REQUIRE(vm_manager->FindVMA(base)->second.permissions == VMAPermission::ReadWrite);
+    REQUIRE(page_table.pointers[base_page + 5] == block->data() + 5 * Memory::PAGE_SIZE);
+
+    // Protecting it back merges the pieces again
+    REQUIRE(vm_manager->ReprotectRange(middle, 4 * Memory::PAGE_SIZE, VMAPermission::ReadWrite) ==
+            RESULT_SUCCESS);
+    REQUIRE(vm_manager->FindVMA(middle)->second.base == base);
+
+    // Unmapping all of the block leaves a single free area and no page behind
+    REQUIRE(vm_manager->UnmapRange(base, num_pages * Memory::PAGE_SIZE) == RESULT_SUCCESS);
+    vma = vm_manager->FindVMA(base + 3 * Memory::PAGE_SIZE);
+    REQUIRE(vma->second.type == VMAType::Free);
+    REQUIRE(vma->second.base == 0);
+    REQUIRE(vma->second.size == VMManager::MAX_ADDRESS);
+    for (size_t page = base_page; page < base_page + num_pages; ++page) {
+        REQUIRE(page_table.GetAttribute(page) == Memory::PageType::Unmapped);
+        REQUIRE(page_table.pointers[page] == nullptr);
+    }
+
+    REQUIRE(vm_manager->FindVMA(VMManager::MAX_ADDRESS) == vm_manager->vma_map.end());
+}
+
+TEST_CASE("VMManager::Benchmark", "[.benchmark]") {
+    // 4 GiB of address space made of 2 MiB mappings, like a large heap built from many blocks
+    constexpr u64 block_size = 2 * 1024 * 1024;
+    constexpr u64 num_blocks = 2048;
+    constexpr u64 range_size = block_size * num_blocks;
+    constexpr VAddr base = Memory::HEAP_VADDR;
+    constexpr int num_lookups = 1000000;
+
+    using Clock = std::chrono::steady_clock;
+    const auto milliseconds = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    // Address spaces are created and destroyed with every process
+    constexpr int num_address_spaces = 16;
+    auto start = Clock::now();
+    for (int i = 0; i < num_address_spaces; ++i) {
+        auto address_space = std::make_unique<VMManager>();
+    }
+    const double create_time = milliseconds(start) / num_address_spaces;
+
+    auto vm_manager = std::make_unique<VMManager>();
+    auto block = std::make_shared<std::vector<u8>>(block_size);
+
+    start = Clock::now();
+    for (u64 i = 0; i < num_blocks; ++i) {
+        REQUIRE(vm_manager->MapMemoryBlock(base + i * block_size, block, 0, block_size,
+                                           MemoryState::Heap)
+                    .Succeeded());
+    }
+    const double map_time = milliseconds(start);
+
+    start = Clock::now();
+    REQUIRE(vm_manager->ReprotectRange(base, range_size, VMAPermission::Read) == RESULT_SUCCESS);
+    const double reprotect_time = milliseconds(start);
+
+    std::mt19937 rng(0x5EED);
+    u64 checksum = 0;
+    start = Clock::now();
+    for (int i = 0; i < num_lookups; ++i) {
+        // Mostly repeated lookups in the same area, as QueryMemory loops and page faults do
+        const VAddr address = base + (rng() % 4 == 0 ? rng() % range_size : i % block_size);
+        checksum += vm_manager->FindVMA(address)->second.base;
+    }
+    const double lookup_time = milliseconds(start);
+
+    start = Clock::now();
+    REQUIRE(vm_manager->UnmapRange(base, range_size) == RESULT_SUCCESS);
+    const double unmap_time = milliseconds(start);
+
+    REQUIRE(checksum != 0);
+    std::printf("4 GiB in %llu mappings: map %.2f ms, reprotect %.2f ms, unmap %.2f ms\n",
+                static_cast<unsigned long long>(num_blocks), map_time, reprotect_time,
+                unmap_time);
+    std::printf("FindVMA: %.1f ns, address space creation: %.2f ms\n",
+                lookup_time * 1000000.0 / num_lookups, create_time);
+}
+
+} // namespace Kernel
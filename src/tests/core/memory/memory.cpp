@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <memory>
+#include <vector>
 #include <catch.hpp>
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/memory.h"
+#include "core/memory_setup.h"
 
 TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory][!hide]") {
     SECTION("these regions should not be mapped on an empty process") {
@@ -54,3 +57,43 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory][!hide]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::PageTable directories", "[core][memory]") {
+    constexpr VAddr base = 0x10000000;
+    constexpr u64 directory_size = Memory::PAGE_DIRECTORY_NUM_ENTRIES * Memory::PAGE_SIZE;
+    const size_t base_page = base >> Memory::PAGE_BITS;
+
+    auto page_table = std::make_unique<Memory::PageTable>();
+    std::vector<u8> memory(3 * directory_size);
+
+    // Nothing is allocated until something is mapped
+    REQUIRE(page_table->FindDirectory(base_page) == nullptr);
+    REQUIRE(page_table->GetAttribute(base_page) == Memory::PageType::Unmapped);
+    REQUIRE(page_table->pointers[base_page] == nullptr);
+
+    // A mapping straddling directories fills all of them
+    const VAddr start = base + directory_size - Memory::PAGE_SIZE;
+    Memory::MapMemoryRegion(*page_table, start, 2 * directory_size, memory.data());
+    const size_t start_page = start >> Memory::PAGE_BITS;
+    const size_t end_page = start_page + 2 * Memory::PAGE_DIRECTORY_NUM_ENTRIES;
+    for (size_t page = start_page; page < end_page; ++page) {
+        REQUIRE(page_table->GetAttribute(page) == Memory::PageType::Memory);
+        REQUIRE(page_table->pointers[page] ==
+                memory.data() + (page - start_page) * Memory::PAGE_SIZE);
+    }
+    REQUIRE(page_table->GetAttribute(start_page - 1) == Memory::PageType::Unmapped);
+    REQUIRE(page_table->GetAttribute(end_page) == Memory::PageType::Unmapped);
+
+    // Unmapping releases the directories it covers entirely, and only those
+    Memory::UnmapRegion(*page_table, start, 2 * directory_size);
+    REQUIRE(page_table->FindDirectory(start_page) != nullptr);
+    REQUIRE(page_table->FindDirectory(start_page + 1) == nullptr);
+    REQUIRE(page_table->FindDirectory(end_page - 1) != nullptr);
+    for (size_t page = start_page; page < end_page; ++page) {
+        REQUIRE(page_table->GetAttribute(page) == Memory::PageType::Unmapped);
+        REQUIRE(page_table->pointers[page] == nullptr);
+    }
+
+    page_table->Clear();
+    REQUIRE(page_table->FindDirectory(start_page) == nullptr);
+}
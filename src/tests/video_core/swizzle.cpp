@@ -0,0 +1,103 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_types.h"
+#include "video_core/swizzle.h"
+
+namespace {
+
+std::vector<u8> MakePattern(size_t size) {
+    std::vector<u8> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<u8>((i * 131) ^ (i >> 8));
+    }
+    return data;
+}
+
+void CheckMatchesReference(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height,
+                           bool flip_y) {
+    const size_t swizzled_size =
+        VideoCore::GetBlockLinearSize(width, height, bytes_per_pixel, block_height);
+    const size_t linear_size = static_cast<size_t>(width) * height * bytes_per_pixel;
+
+    // Unswizzling
+    std::vector<u8> swizzled = MakePattern(swizzled_size);
+    std::vector<u8> expected(linear_size);
+    std::vector<u8> actual(linear_size);
+    VideoCore::CopySwizzledDataPerPixel(width, height, bytes_per_pixel, block_height,
+                                        swizzled.data(), expected.data(), true, flip_y);
+    VideoCore::CopySwizzledData(width, height, bytes_per_pixel, block_height, swizzled.data(),
+                                actual.data(), true, flip_y);
+    REQUIRE(actual == expected);
+
+    // Swizzling
+    std::vector<u8> linear = MakePattern(linear_size);
+    std::vector<u8> expected_swizzled(swizzled_size);
+    std::vector<u8> actual_swizzled(swizzled_size);
+    VideoCore::CopySwizzledDataPerPixel(width, height, bytes_per_pixel, block_height,
+                                        expected_swizzled.data(), linear.data(), false, flip_y);
+    VideoCore::CopySwizzledData(width, height, bytes_per_pixel, block_height,
+                                actual_swizzled.data(), linear.data(), false, flip_y);
+    REQUIRE(actual_swizzled == expected_swizzled);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Swizzle::GobLayout", "[video_core]") {
+    // The first line of a GOB is split into sectors at 0, 32, 256 and 288 bytes, with the second
+    // line filling the gaps in between.
+    REQUIRE(VideoCore::GetBlockLinearOffset(0, 0, 1, 1) == 0);
+    REQUIRE(VideoCore::GetBlockLinearOffset(16, 0, 1, 1) == 32);
+    REQUIRE(VideoCore::GetBlockLinearOffset(32, 0, 1, 1) == 256);
+    REQUIRE(VideoCore::GetBlockLinearOffset(48, 0, 1, 1) == 288);
+    REQUIRE(VideoCore::GetBlockLinearOffset(0, 1, 1, 1) == 16);
+    REQUIRE(VideoCore::GetBlockLinearOffset(0, 2, 1, 1) == 64);
+    REQUIRE(VideoCore::GetBlockLinearOffset(0, 8, 1, 16) == VideoCore::GOB_SIZE);
+    REQUIRE(VideoCore::GetBlockLinearOffset(64, 0, 2, 16) == VideoCore::GOB_SIZE * 16);
+    REQUIRE(VideoCore::GetBlockLinearOffset(0, 128, 2, 16) == VideoCore::GOB_SIZE * 16 * 2);
+}
+
+TEST_CASE("Swizzle::MatchesPerPixelCopy", "[video_core]") {
+    SECTION("framebuffer sized image") {
+        CheckMatchesReference(1280, 720, 4, VideoCore::FRAMEBUFFER_BLOCK_HEIGHT, true);
+    }
+    SECTION("width not a multiple of a GOB") {
+        CheckMatchesReference(1000, 130, 4, VideoCore::FRAMEBUFFER_BLOCK_HEIGHT, false);
+    }
+    SECTION("odd width and height") {
+        CheckMatchesReference(37, 19, 2, 2, true);
+    }
+    SECTION("single line") {
+        CheckMatchesReference(100, 1, 2, 1, false);
+    }
+}
+
+TEST_CASE("Swizzle::Benchmark", "[.benchmark]") {
+    constexpr u32 width = 1280;
+    constexpr u32 height = 720;
+    constexpr u32 bytes_per_pixel = 4;
+    constexpr int iterations = 200;
+
+    std::vector<u8> swizzled = MakePattern(VideoCore::GetBlockLinearSize(
+        width, height, bytes_per_pixel, VideoCore::FRAMEBUFFER_BLOCK_HEIGHT));
+    std::vector<u8> linear(width * height * bytes_per_pixel);
+
+    const auto run = [&](const char* name, auto&& copy) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            copy(width, height, bytes_per_pixel, VideoCore::FRAMEBUFFER_BLOCK_HEIGHT,
+                 swizzled.data(), linear.data(), true, true);
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        std::printf("%-10s %8.1f us/frame\n", name, elapsed.count() / iterations);
+    };
+
+    run("per-pixel", VideoCore::CopySwizzledDataPerPixel);
+    run("gob-line", VideoCore::CopySwizzledData);
+}
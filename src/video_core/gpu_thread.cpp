@@ -0,0 +1,92 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+MICROPROFILE_DEFINE(GPU_Present, "GPU", "Present", MP_RGB(128, 128, 192));
+
+GPUThread::GPUThread(RendererBase& renderer, EmuWindow& emu_window)
+    : renderer(renderer), emu_window(emu_window) {
+    // The GL context can only be current on one thread at a time, hand it over to the GPU thread
+    emu_window.DoneCurrent();
+    thread = std::thread(&GPUThread::ThreadLoop, this);
+}
+
+GPUThread::~GPUThread() {
+    {
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        stop_requested = true;
+    }
+    ring_not_empty.notify_one();
+    thread.join();
+
+    // Take the GL context back so that the renderer can be destroyed on the emulation thread
+    emu_window.MakeCurrent();
+}
+
+u64 GPUThread::SwapBuffers(const RendererBase::Composition& composition, u64 emulated_time_us) {
+    std::unique_lock<std::mutex> lock(ring_mutex);
+    ring_not_full.wait(lock, [this] { return ring_count < RING_SIZE; });
+
+    FrameCommand& command = ring[ring_write];
+    command.composition = composition;
+    command.emulated_time_us = emulated_time_us;
+    const u64 fence = command.fence = ++next_fence;
+
+    ring_write = (ring_write + 1) % RING_SIZE;
+    ++ring_count;
+    lock.unlock();
+    ring_not_empty.notify_one();
+
+    return fence;
+}
+
+void GPUThread::SignalFence(u64 fence) {
+    signalled_fence.store(fence, std::memory_order_release);
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPU");
+    emu_window.MakeCurrent();
+
+    while (true) {
+        FrameCommand command;
+        {
+            std::unique_lock<std::mutex> lock(ring_mutex);
+            ring_not_empty.wait(lock, [this] { return stop_requested || ring_count != 0; });
+            if (stop_requested) {
+                break;
+            }
+            command = ring[ring_read];
+        }
+
+        MICROPROFILE_SCOPE(GPU_Present);
+
+        // The guest may reuse the framebuffers as soon as they have been copied out of emulated
+        // memory
+        renderer.LoadFrame(command.composition);
+        SignalFence(command.fence);
+
+        // Only free the ring entry once the frame is presented, so that the emulation thread is
+        // throttled by presentation and frame limiting
+        renderer.PresentFrame(command.composition, command.emulated_time_us);
+        {
+            std::lock_guard<std::mutex> lock(ring_mutex);
+            ring_read = (ring_read + 1) % RING_SIZE;
+            --ring_count;
+        }
+        ring_not_full.notify_one();
+    }
+
+    emu_window.DoneCurrent();
+    LOG_DEBUG(Render, "GPU thread stopped");
+}
+
+} // namespace VideoCore
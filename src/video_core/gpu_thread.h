@@ -0,0 +1,75 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "common/common_types.h"
+#include "video_core/renderer_base.h"
+
+class EmuWindow;
+
+namespace VideoCore {
+
+/**
+ * Presents frames on a dedicated host thread, so that texture uploads and presentation overlap with
+ * CPU emulation. Frames are handed over through a small command ring; the emulation thread only
+ * blocks when the GPU thread is a full ring behind, which also lets the frame limiter on the GPU
+ * thread throttle emulation.
+ */
+class GPUThread final {
+public:
+    GPUThread(RendererBase& renderer, EmuWindow& emu_window);
+    ~GPUThread();
+
+    /**
+     * Queues a frame for presentation
+     * @param composition Layers to display, without any framebuffer to present the previous frame
+     * again
+     * @param emulated_time_us Emulated time at which the frame was flipped, used for frame limiting
+     * @return Fence that is signalled once the framebuffers have been read from emulated memory
+     */
+    u64 SwapBuffers(const RendererBase::Composition& composition, u64 emulated_time_us);
+
+    /// Returns whether the GPU thread is done reading the framebuffer of the given fence
+    bool IsFenceSignalled(u64 fence) const {
+        return signalled_fence.load(std::memory_order_acquire) >= fence;
+    }
+
+private:
+    struct FrameCommand {
+        RendererBase::Composition composition;
+        u64 emulated_time_us;
+        u64 fence;
+    };
+
+    /// Number of frames the emulation thread may run ahead of presentation
+    static constexpr size_t RING_SIZE = 2;
+
+    void ThreadLoop();
+    void SignalFence(u64 fence);
+
+    RendererBase& renderer;
+    EmuWindow& emu_window;
+
+    std::array<FrameCommand, RING_SIZE> ring;
+    size_t ring_read = 0;  ///< Index of the next command to present, owned by the GPU thread
+    size_t ring_write = 0; ///< Index of the next free command, owned by the emulation thread
+    size_t ring_count = 0;
+    bool stop_requested = false;
+    std::mutex ring_mutex;
+    std::condition_variable ring_not_empty;
+    std::condition_variable ring_not_full;
+
+    u64 next_fence = 0;
+    std::atomic<u64> signalled_fence{0};
+
+    std::thread thread;
+};
+
+} // namespace VideoCore
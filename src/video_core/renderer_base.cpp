@@ -4,7 +4,50 @@
 
 #include <atomic>
 #include <memory>
+#include "core/core.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
+void RendererBase::SwapBuffers(const Composition& composition, u64 emulated_time_us) {
+    LoadFrame(composition);
+    PresentFrame(composition, emulated_time_us);
+}
+
+void RendererBase::LoadFrame(const Composition& composition) {
+    const auto load_begin = Core::PerfStats::Clock::now();
+    for (size_t layer = 0; layer < composition.num_layers; ++layer) {
+        // Layers which weren't flipped keep their contents and don't need to be uploaded again
+        if (composition.framebuffers[layer] != boost::none) {
+            LoadFramebuffer(layer, *composition.framebuffers[layer]);
+        }
+    }
+    Core::System::GetInstance().perf_stats.AddSubsystemTime(
+        Core::PerfStats::Subsystem::Video, Core::PerfStats::Clock::now() - load_begin);
+}
+
+void RendererBase::PresentFrame(const Composition& composition, u64 emulated_time_us) {
+    auto& system = Core::System::GetInstance();
+
+    // Without a new framebuffer the window would show the same picture again, so only the pacing
+    // of the frame is kept
+    if (composition.HasNewFramebuffer() || composition.num_layers != presented_layers ||
+        NeedsRepaint()) {
+        const auto present_begin = Core::PerfStats::Clock::now();
+        Present(composition.num_layers);
+        presented_layers = composition.num_layers;
+        system.perf_stats.AddSubsystemTime(Core::PerfStats::Subsystem::Video,
+                                           Core::PerfStats::Clock::now() - present_begin);
+    } else {
+        system.perf_stats.AddPresentSkip();
+    }
+
+    m_current_frame++;
+    system.perf_stats.EndSystemFrame();
+    const auto wakeup_error = system.frame_limiter.DoFrameLimiting(emulated_time_us);
+    if (wakeup_error) {
+        system.perf_stats.AddFrameLimiterWait(*wakeup_error);
+    }
+    system.perf_stats.BeginSystemFrame();
+}
+
 void RendererBase::RefreshRasterizerSetting() {}
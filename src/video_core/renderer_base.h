@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <boost/optional.hpp>
 #include "common/assert.h"
@@ -45,10 +48,55 @@ public:
         PixelFormat pixel_format;
     };
 
+    /// Maximum number of layers composed into a frame, each one is drawn from its own texture unit
+    static constexpr size_t MAX_LAYERS = 3;
+
+    /**
+     * Layers to compose into a frame, drawn in order starting from the bottom one. Only the layers
+     * with a newly flipped framebuffer have one, the others keep showing their previous contents.
+     */
+    struct Composition {
+        size_t num_layers = 0;
+        std::array<boost::optional<FramebufferInfo>, MAX_LAYERS> framebuffers;
+
+        /// Returns whether any layer has a newly flipped framebuffer
+        bool HasNewFramebuffer() const {
+            return std::any_of(framebuffers.begin(), framebuffers.begin() + num_layers,
+                               [](const auto& framebuffer) { return framebuffer != boost::none; });
+        }
+    };
+
     virtual ~RendererBase() {}
 
-    /// Swap buffers (render frame)
-    virtual void SwapBuffers(boost::optional<const FramebufferInfo&> framebuffer_info) = 0;
+    /**
+     * Copies the framebuffer of a layer out of emulated memory. Once this returns, the guest is
+     * free to reuse the framebuffer.
+     */
+    virtual void LoadFramebuffer(size_t layer, const FramebufferInfo& framebuffer_info) = 0;
+
+    /**
+     * Blends the most recently loaded framebuffers of the first `num_layers` layers to the window
+     * and swaps the window buffers
+     */
+    virtual void Present(size_t num_layers) = 0;
+
+    /**
+     * Swap buffers (render frame)
+     * @param composition Layers to display, without any framebuffer to present the previous frame
+     * again
+     * @param emulated_time_us Emulated time at which the frame was flipped, used for frame limiting
+     */
+    void SwapBuffers(const Composition& composition, u64 emulated_time_us);
+
+    /// Loads the framebuffers of a composition, accounting the time it took in the perf stats
+    void LoadFrame(const Composition& composition);
+
+    /**
+     * Presents the loaded framebuffers, then updates the perf stats and limits the framerate. The
+     * host window is only updated when the composition changed or it needs a repaint, but the
+     * frame is always counted and paced.
+     */
+    void PresentFrame(const Composition& composition, u64 emulated_time_us);
 
     /**
      * Set the emulator window to use for renderer
@@ -76,9 +124,20 @@ public:
     void RefreshRasterizerSetting();
 
 protected:
+    /**
+     * Returns whether the window has to be drawn again even though no layer changed, for example
+     * because its framebuffer layout changed since the last present
+     */
+    virtual bool NeedsRepaint() const {
+        return false;
+    }
+
     f32 m_current_fps = 0.0f; ///< Current framerate, should be set by the renderer
-    int m_current_frame = 0;  ///< Current frame, should be set by the renderer
+    /// Number of frames flipped by the guest, including the ones not presented on the host
+    std::atomic<int> m_current_frame{0};
 
 private:
     bool opengl_rasterizer_active = false;
+    /// Number of layers of the last frame presented on the host
+    size_t presented_layers = 0;
 };
@@ -0,0 +1,67 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/memory.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/swizzle.h"
+
+RendererNull::RendererNull() = default;
+RendererNull::~RendererNull() = default;
+
+void RendererNull::LoadFramebuffer(size_t layer_index, const FramebufferInfo& framebuffer_info) {
+    Layer& layer = layers[layer_index];
+
+    const u32 bpp{FramebufferInfo::BytesPerPixel(framebuffer_info.pixel_format)};
+    const size_t swizzled_size{VideoCore::GetBlockLinearSize(
+        framebuffer_info.width, framebuffer_info.height, bpp, VideoCore::FRAMEBUFFER_BLOCK_HEIGHT)};
+
+    Memory::RasterizerFlushRegion(framebuffer_info.address, swizzled_size);
+
+    // Unchanged framebuffers are skipped the same way the OpenGL renderer skips them
+    u8* swizzled_data = Memory::GetPointer(framebuffer_info.address);
+    const u64 hash{Common::ComputeHash64(swizzled_data, swizzled_size)};
+    auto& perf_stats = Core::System::GetInstance().perf_stats;
+    if (layer.contents_hash && *layer.contents_hash == hash) {
+        perf_stats.AddFramebufferLoad(false);
+        return;
+    }
+    layer.contents_hash = hash;
+    perf_stats.AddFramebufferLoad(true);
+    layers_changed = true;
+
+    framebuffer_data.resize(framebuffer_info.width * framebuffer_info.height * bpp);
+    VideoCore::CopySwizzledData(framebuffer_info.width, framebuffer_info.height, bpp,
+                                VideoCore::FRAMEBUFFER_BLOCK_HEIGHT, swizzled_data,
+                                framebuffer_data.data(), true, true);
+    layer.frame_hash = Common::ComputeHash64(framebuffer_data.data(), framebuffer_data.size());
+
+    LOG_TRACE(Render, "Loaded framebuffer at 0x%llx (%ux%u) on layer %zu, hash %016llx",
+              framebuffer_info.address, framebuffer_info.width, framebuffer_info.height,
+              layer_index, static_cast<unsigned long long>(layer.frame_hash));
+}
+
+void RendererNull::Present(size_t num_layers) {
+    if (layers_changed) {
+        std::array<u64, MAX_LAYERS + 1> hashes{};
+        hashes[0] = output_hash;
+        for (size_t i = 0; i < num_layers; ++i) {
+            hashes[i + 1] = layers[i].frame_hash;
+        }
+        output_hash = Common::ComputeHash64(hashes.data(), (num_layers + 1) * sizeof(u64));
+        layers_changed = false;
+    }
+}
+
+void RendererNull::SetWindow(EmuWindow* window) {}
+
+bool RendererNull::Init() {
+    LOG_INFO(Render, "Using the null renderer, nothing will be displayed");
+    return true;
+}
+
+void RendererNull::ShutDown() {}
@@ -0,0 +1,53 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "video_core/renderer_base.h"
+
+class EmuWindow;
+
+/**
+ * Renderer which displays nothing, for running without a GPU. Flipped framebuffers are still
+ * copied out of emulated memory and deswizzled, so that the work the CPU does per frame matches
+ * the OpenGL renderer and the output can be checked through its hash.
+ */
+class RendererNull : public RendererBase {
+public:
+    RendererNull();
+    ~RendererNull() override;
+
+    void LoadFramebuffer(size_t layer, const FramebufferInfo& framebuffer_info) override;
+    void Present(size_t num_layers) override;
+    void SetWindow(EmuWindow* window) override;
+    bool Init() override;
+    void ShutDown() override;
+
+    /// Returns a hash of every distinct frame presented so far, in order
+    u64 GetOutputHash() const {
+        return output_hash;
+    }
+
+private:
+    struct Layer {
+        /// Hash of the guest framebuffer last loaded, if any
+        boost::optional<u64> contents_hash;
+        /// Hash of the deswizzled contents of the last loaded framebuffer
+        u64 frame_hash = 0;
+    };
+
+    std::array<Layer, MAX_LAYERS> layers;
+    /// Whether any layer was loaded since the last presented frame
+    bool layers_changed = false;
+
+    /// Deswizzled contents of the last loaded framebuffer
+    std::vector<u8> framebuffer_data;
+
+    std::atomic<u64> output_hash{0};
+};
@@ -142,6 +142,38 @@ public:
     GLuint handle = 0;
 };
 
+class OGLSync : private NonCopyable {
+public:
+    OGLSync() = default;
+    OGLSync(OGLSync&& o) {
+        std::swap(handle, o.handle);
+    }
+    ~OGLSync() {
+        Release();
+    }
+    OGLSync& operator=(OGLSync&& o) {
+        std::swap(handle, o.handle);
+        return *this;
+    }
+
+    /// Creates a fence which is signalled once all the commands issued so far have completed
+    void Create() {
+        if (handle != nullptr)
+            return;
+        handle = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    /// Deletes the internal OpenGL resource
+    void Release() {
+        if (handle == nullptr)
+            return;
+        glDeleteSync(handle);
+        handle = nullptr;
+    }
+
+    GLsync handle = nullptr;
+};
+
 class OGLVertexArray : private NonCopyable {
 public:
     OGLVertexArray() = default;
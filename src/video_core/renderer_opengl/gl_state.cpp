@@ -67,6 +67,7 @@ OpenGLState::OpenGLState() {
     draw.vertex_array = 0;
     draw.vertex_buffer = 0;
     draw.uniform_buffer = 0;
+    draw.pixel_unpack_buffer = 0;
     draw.shader_program = 0;
 
     clip_distance = {};
@@ -258,6 +259,11 @@ void OpenGLState::Apply() const {
         glBindBuffer(GL_UNIFORM_BUFFER, draw.uniform_buffer);
     }
 
+    // Pixel unpack buffer
+    if (draw.pixel_unpack_buffer != cur_state.draw.pixel_unpack_buffer) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, draw.pixel_unpack_buffer);
+    }
+
     // Shader program
     if (draw.shader_program != cur_state.draw.shader_program) {
         glUseProgram(draw.shader_program);
@@ -320,6 +326,9 @@ void OpenGLState::ResetBuffer(GLuint handle) {
     if (cur_state.draw.uniform_buffer == handle) {
         cur_state.draw.uniform_buffer = 0;
     }
+    if (cur_state.draw.pixel_unpack_buffer == handle) {
+        cur_state.draw.pixel_unpack_buffer = 0;
+    }
 }
 
 void OpenGLState::ResetVertexArray(GLuint handle) {
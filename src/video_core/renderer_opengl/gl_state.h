@@ -116,12 +116,13 @@ public:
     } proctex_diff_lut;
 
     struct {
-        GLuint read_framebuffer; // GL_READ_FRAMEBUFFER_BINDING
-        GLuint draw_framebuffer; // GL_DRAW_FRAMEBUFFER_BINDING
-        GLuint vertex_array;     // GL_VERTEX_ARRAY_BINDING
-        GLuint vertex_buffer;    // GL_ARRAY_BUFFER_BINDING
-        GLuint uniform_buffer;   // GL_UNIFORM_BUFFER_BINDING
-        GLuint shader_program;   // GL_CURRENT_PROGRAM
+        GLuint read_framebuffer;    // GL_READ_FRAMEBUFFER_BINDING
+        GLuint draw_framebuffer;    // GL_DRAW_FRAMEBUFFER_BINDING
+        GLuint vertex_array;        // GL_VERTEX_ARRAY_BINDING
+        GLuint vertex_buffer;       // GL_ARRAY_BUFFER_BINDING
+        GLuint uniform_buffer;      // GL_UNIFORM_BUFFER_BINDING
+        GLuint pixel_unpack_buffer; // GL_PIXEL_UNPACK_BUFFER_BINDING
+        GLuint shader_program;      // GL_CURRENT_PROGRAM
     } draw;
 
     std::array<bool, 2> clip_distance; // GL_CLIP_DISTANCE
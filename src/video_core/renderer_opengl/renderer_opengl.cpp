@@ -10,9 +10,9 @@
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "core/core.h"
-#include "core/core_timing.h"
 #include "core/frontend/emu_window.h"
 #include "core/hw/hw.h"
 #include "core/hw/lcd.h"
@@ -20,6 +20,7 @@
 #include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/swizzle.h"
 #include "video_core/video_core.h"
 
 static const char vertex_shader[] = R"(
@@ -51,15 +52,32 @@ static const char fragment_shader[] = R"(
 in vec2 frag_tex_coord;
 out vec4 color;
 
-uniform sampler2D color_texture;
+// One texture per layer, starting with the bottom one
+uniform sampler2D layer_textures[3];
+uniform int num_layers;
+
+// Swap RGBA -> ABGR so we don't have to do this on the CPU. This needs to change if we have to
+// support more framebuffer pixel formats.
+vec4 SampleLayer(sampler2D layer_texture) {
+    return texture(layer_texture, frag_tex_coord).abgr;
+}
 
 void main() {
-    // Swap RGBA -> ABGR so we don't have to do this on the CPU. This needs to change if we have to
-    // support more framebuffer pixel formats.
-    color = texture(color_texture, frag_tex_coord).abgr;
+    // Sampler arrays may only be indexed by constants in GLSL 1.50, so the blending is unrolled
+    color = SampleLayer(layer_textures[0]);
+    if (num_layers > 1) {
+        vec4 layer = SampleLayer(layer_textures[1]);
+        color.rgb = mix(color.rgb, layer.rgb, layer.a);
+    }
+    if (num_layers > 2) {
+        vec4 layer = SampleLayer(layer_textures[2]);
+        color.rgb = mix(color.rgb, layer.rgb, layer.a);
+    }
 }
 )";
 
+static_assert(RendererBase::MAX_LAYERS == 3, "The fragment shader blends exactly three layers");
+
 /**
  * Vertex structure that the drawn screen rectangles are composed of.
  */
@@ -97,151 +115,39 @@ static std::array<GLfloat, 3 * 2> MakeOrthographicMatrix(const float width, cons
 RendererOpenGL::RendererOpenGL() = default;
 RendererOpenGL::~RendererOpenGL() = default;
 
-/// Swap buffers (render frame)
-void RendererOpenGL::SwapBuffers(boost::optional<const FramebufferInfo&> framebuffer_info) {
+void RendererOpenGL::LoadFramebuffer(size_t layer, const FramebufferInfo& framebuffer_info) {
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
 
-    if (framebuffer_info != boost::none) {
-        // If framebuffer_info is provided, reload it from memory to a texture
-        if (screen_info.texture.width != (GLsizei)framebuffer_info->width ||
-            screen_info.texture.height != (GLsizei)framebuffer_info->height ||
-            screen_info.texture.pixel_format != framebuffer_info->pixel_format) {
-            // Reallocate texture if the framebuffer size has changed.
-            // This is expected to not happen very often and hence should not be a
-            // performance problem.
-            ConfigureFramebufferTexture(screen_info.texture, *framebuffer_info);
-        }
-        LoadFBToScreenInfo(*framebuffer_info, screen_info);
+    ScreenInfo& screen_info = layers[layer];
+    if (screen_info.texture.width != (GLsizei)framebuffer_info.width ||
+        screen_info.texture.height != (GLsizei)framebuffer_info.height ||
+        screen_info.texture.pixel_format != framebuffer_info.pixel_format) {
+        // Reallocate texture if the framebuffer size has changed.
+        // This is expected to not happen very often and hence should not be a
+        // performance problem.
+        ConfigureFramebufferTexture(screen_info.texture, framebuffer_info);
     }
+    LoadFBToScreenInfo(framebuffer_info, screen_info);
 
-    DrawScreens();
+    prev_state.Apply();
+}
 
-    Core::System::GetInstance().perf_stats.EndSystemFrame();
+void RendererOpenGL::Present(size_t num_layers) {
+    // Maintain the rasterizer's state as a priority
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    state.Apply();
+
+    DrawScreens(num_layers);
 
     // Swap buffers
-    render_window->PollEvents();
     render_window->SwapBuffers();
 
-    Core::System::GetInstance().frame_limiter.DoFrameLimiting(CoreTiming::GetGlobalTimeUs());
-    Core::System::GetInstance().perf_stats.BeginSystemFrame();
-
     prev_state.Apply();
     RefreshRasterizerSetting();
 }
 
-static inline u32 MortonInterleave128(u32 x, u32 y) {
-    // 128x128 Z-Order coordinate from 2D coordinates
-    static constexpr u32 xlut[] = {
-        0x0000, 0x0001, 0x0002, 0x0003, 0x0008, 0x0009, 0x000a, 0x000b, 0x0040, 0x0041, 0x0042,
-        0x0043, 0x0048, 0x0049, 0x004a, 0x004b, 0x0800, 0x0801, 0x0802, 0x0803, 0x0808, 0x0809,
-        0x080a, 0x080b, 0x0840, 0x0841, 0x0842, 0x0843, 0x0848, 0x0849, 0x084a, 0x084b, 0x1000,
-        0x1001, 0x1002, 0x1003, 0x1008, 0x1009, 0x100a, 0x100b, 0x1040, 0x1041, 0x1042, 0x1043,
-        0x1048, 0x1049, 0x104a, 0x104b, 0x1800, 0x1801, 0x1802, 0x1803, 0x1808, 0x1809, 0x180a,
-        0x180b, 0x1840, 0x1841, 0x1842, 0x1843, 0x1848, 0x1849, 0x184a, 0x184b, 0x2000, 0x2001,
-        0x2002, 0x2003, 0x2008, 0x2009, 0x200a, 0x200b, 0x2040, 0x2041, 0x2042, 0x2043, 0x2048,
-        0x2049, 0x204a, 0x204b, 0x2800, 0x2801, 0x2802, 0x2803, 0x2808, 0x2809, 0x280a, 0x280b,
-        0x2840, 0x2841, 0x2842, 0x2843, 0x2848, 0x2849, 0x284a, 0x284b, 0x3000, 0x3001, 0x3002,
-        0x3003, 0x3008, 0x3009, 0x300a, 0x300b, 0x3040, 0x3041, 0x3042, 0x3043, 0x3048, 0x3049,
-        0x304a, 0x304b, 0x3800, 0x3801, 0x3802, 0x3803, 0x3808, 0x3809, 0x380a, 0x380b, 0x3840,
-        0x3841, 0x3842, 0x3843, 0x3848, 0x3849, 0x384a, 0x384b, 0x0000, 0x0001, 0x0002, 0x0003,
-        0x0008, 0x0009, 0x000a, 0x000b, 0x0040, 0x0041, 0x0042, 0x0043, 0x0048, 0x0049, 0x004a,
-        0x004b, 0x0800, 0x0801, 0x0802, 0x0803, 0x0808, 0x0809, 0x080a, 0x080b, 0x0840, 0x0841,
-        0x0842, 0x0843, 0x0848, 0x0849, 0x084a, 0x084b, 0x1000, 0x1001, 0x1002, 0x1003, 0x1008,
-        0x1009, 0x100a, 0x100b, 0x1040, 0x1041, 0x1042, 0x1043, 0x1048, 0x1049, 0x104a, 0x104b,
-        0x1800, 0x1801, 0x1802, 0x1803, 0x1808, 0x1809, 0x180a, 0x180b, 0x1840, 0x1841, 0x1842,
-        0x1843, 0x1848, 0x1849, 0x184a, 0x184b, 0x2000, 0x2001, 0x2002, 0x2003, 0x2008, 0x2009,
-        0x200a, 0x200b, 0x2040, 0x2041, 0x2042, 0x2043, 0x2048, 0x2049, 0x204a, 0x204b, 0x2800,
-        0x2801, 0x2802, 0x2803, 0x2808, 0x2809, 0x280a, 0x280b, 0x2840, 0x2841, 0x2842, 0x2843,
-        0x2848, 0x2849, 0x284a, 0x284b, 0x3000, 0x3001, 0x3002, 0x3003, 0x3008, 0x3009, 0x300a,
-        0x300b, 0x3040, 0x3041, 0x3042, 0x3043, 0x3048, 0x3049, 0x304a, 0x304b, 0x3800, 0x3801,
-        0x3802, 0x3803, 0x3808, 0x3809, 0x380a, 0x380b, 0x3840, 0x3841, 0x3842, 0x3843, 0x3848,
-        0x3849, 0x384a, 0x384b, 0x0000, 0x0001, 0x0002, 0x0003, 0x0008, 0x0009, 0x000a, 0x000b,
-        0x0040, 0x0041, 0x0042, 0x0043, 0x0048, 0x0049, 0x004a, 0x004b, 0x0800, 0x0801, 0x0802,
-        0x0803, 0x0808, 0x0809, 0x080a, 0x080b, 0x0840, 0x0841, 0x0842, 0x0843, 0x0848, 0x0849,
-        0x084a, 0x084b, 0x1000, 0x1001, 0x1002, 0x1003, 0x1008, 0x1009, 0x100a, 0x100b, 0x1040,
-        0x1041, 0x1042, 0x1043, 0x1048, 0x1049, 0x104a, 0x104b, 0x1800, 0x1801, 0x1802, 0x1803,
-        0x1808, 0x1809, 0x180a, 0x180b, 0x1840, 0x1841, 0x1842, 0x1843, 0x1848, 0x1849, 0x184a,
-        0x184b, 0x2000, 0x2001, 0x2002, 0x2003, 0x2008, 0x2009, 0x200a, 0x200b, 0x2040, 0x2041,
-        0x2042, 0x2043, 0x2048, 0x2049, 0x204a, 0x204b, 0x2800, 0x2801, 0x2802, 0x2803, 0x2808,
-        0x2809, 0x280a, 0x280b, 0x2840, 0x2841, 0x2842, 0x2843, 0x2848, 0x2849, 0x284a, 0x284b,
-        0x3000, 0x3001, 0x3002, 0x3003, 0x3008, 0x3009, 0x300a, 0x300b, 0x3040, 0x3041, 0x3042,
-        0x3043, 0x3048, 0x3049, 0x304a, 0x304b, 0x3800, 0x3801, 0x3802, 0x3803, 0x3808, 0x3809,
-        0x380a, 0x380b, 0x3840, 0x3841, 0x3842, 0x3843, 0x3848, 0x3849, 0x384a, 0x384b,
-    };
-    static constexpr u32 ylut[] = {
-        0x0000, 0x0004, 0x0010, 0x0014, 0x0020, 0x0024, 0x0030, 0x0034, 0x0080, 0x0084, 0x0090,
-        0x0094, 0x00a0, 0x00a4, 0x00b0, 0x00b4, 0x0100, 0x0104, 0x0110, 0x0114, 0x0120, 0x0124,
-        0x0130, 0x0134, 0x0180, 0x0184, 0x0190, 0x0194, 0x01a0, 0x01a4, 0x01b0, 0x01b4, 0x0200,
-        0x0204, 0x0210, 0x0214, 0x0220, 0x0224, 0x0230, 0x0234, 0x0280, 0x0284, 0x0290, 0x0294,
-        0x02a0, 0x02a4, 0x02b0, 0x02b4, 0x0300, 0x0304, 0x0310, 0x0314, 0x0320, 0x0324, 0x0330,
-        0x0334, 0x0380, 0x0384, 0x0390, 0x0394, 0x03a0, 0x03a4, 0x03b0, 0x03b4, 0x0400, 0x0404,
-        0x0410, 0x0414, 0x0420, 0x0424, 0x0430, 0x0434, 0x0480, 0x0484, 0x0490, 0x0494, 0x04a0,
-        0x04a4, 0x04b0, 0x04b4, 0x0500, 0x0504, 0x0510, 0x0514, 0x0520, 0x0524, 0x0530, 0x0534,
-        0x0580, 0x0584, 0x0590, 0x0594, 0x05a0, 0x05a4, 0x05b0, 0x05b4, 0x0600, 0x0604, 0x0610,
-        0x0614, 0x0620, 0x0624, 0x0630, 0x0634, 0x0680, 0x0684, 0x0690, 0x0694, 0x06a0, 0x06a4,
-        0x06b0, 0x06b4, 0x0700, 0x0704, 0x0710, 0x0714, 0x0720, 0x0724, 0x0730, 0x0734, 0x0780,
-        0x0784, 0x0790, 0x0794, 0x07a0, 0x07a4, 0x07b0, 0x07b4, 0x0000, 0x0004, 0x0010, 0x0014,
-        0x0020, 0x0024, 0x0030, 0x0034, 0x0080, 0x0084, 0x0090, 0x0094, 0x00a0, 0x00a4, 0x00b0,
-        0x00b4, 0x0100, 0x0104, 0x0110, 0x0114, 0x0120, 0x0124, 0x0130, 0x0134, 0x0180, 0x0184,
-        0x0190, 0x0194, 0x01a0, 0x01a4, 0x01b0, 0x01b4, 0x0200, 0x0204, 0x0210, 0x0214, 0x0220,
-        0x0224, 0x0230, 0x0234, 0x0280, 0x0284, 0x0290, 0x0294, 0x02a0, 0x02a4, 0x02b0, 0x02b4,
-        0x0300, 0x0304, 0x0310, 0x0314, 0x0320, 0x0324, 0x0330, 0x0334, 0x0380, 0x0384, 0x0390,
-        0x0394, 0x03a0, 0x03a4, 0x03b0, 0x03b4, 0x0400, 0x0404, 0x0410, 0x0414, 0x0420, 0x0424,
-        0x0430, 0x0434, 0x0480, 0x0484, 0x0490, 0x0494, 0x04a0, 0x04a4, 0x04b0, 0x04b4, 0x0500,
-        0x0504, 0x0510, 0x0514, 0x0520, 0x0524, 0x0530, 0x0534, 0x0580, 0x0584, 0x0590, 0x0594,
-        0x05a0, 0x05a4, 0x05b0, 0x05b4, 0x0600, 0x0604, 0x0610, 0x0614, 0x0620, 0x0624, 0x0630,
-        0x0634, 0x0680, 0x0684, 0x0690, 0x0694, 0x06a0, 0x06a4, 0x06b0, 0x06b4, 0x0700, 0x0704,
-        0x0710, 0x0714, 0x0720, 0x0724, 0x0730, 0x0734, 0x0780, 0x0784, 0x0790, 0x0794, 0x07a0,
-        0x07a4, 0x07b0, 0x07b4, 0x0000, 0x0004, 0x0010, 0x0014, 0x0020, 0x0024, 0x0030, 0x0034,
-        0x0080, 0x0084, 0x0090, 0x0094, 0x00a0, 0x00a4, 0x00b0, 0x00b4, 0x0100, 0x0104, 0x0110,
-        0x0114, 0x0120, 0x0124, 0x0130, 0x0134, 0x0180, 0x0184, 0x0190, 0x0194, 0x01a0, 0x01a4,
-        0x01b0, 0x01b4, 0x0200, 0x0204, 0x0210, 0x0214, 0x0220, 0x0224, 0x0230, 0x0234, 0x0280,
-        0x0284, 0x0290, 0x0294, 0x02a0, 0x02a4, 0x02b0, 0x02b4, 0x0300, 0x0304, 0x0310, 0x0314,
-        0x0320, 0x0324, 0x0330, 0x0334, 0x0380, 0x0384, 0x0390, 0x0394, 0x03a0, 0x03a4, 0x03b0,
-        0x03b4, 0x0400, 0x0404, 0x0410, 0x0414, 0x0420, 0x0424, 0x0430, 0x0434, 0x0480, 0x0484,
-        0x0490, 0x0494, 0x04a0, 0x04a4, 0x04b0, 0x04b4, 0x0500, 0x0504, 0x0510, 0x0514, 0x0520,
-        0x0524, 0x0530, 0x0534, 0x0580, 0x0584, 0x0590, 0x0594, 0x05a0, 0x05a4, 0x05b0, 0x05b4,
-        0x0600, 0x0604, 0x0610, 0x0614, 0x0620, 0x0624, 0x0630, 0x0634, 0x0680, 0x0684, 0x0690,
-        0x0694, 0x06a0, 0x06a4, 0x06b0, 0x06b4, 0x0700, 0x0704, 0x0710, 0x0714, 0x0720, 0x0724,
-        0x0730, 0x0734, 0x0780, 0x0784, 0x0790, 0x0794, 0x07a0, 0x07a4, 0x07b0, 0x07b4,
-    };
-    return xlut[x % 128] + ylut[y % 128];
-}
-
-static inline u32 GetMortonOffset128(u32 x, u32 y, u32 bytes_per_pixel) {
-    // Calculates the offset of the position of the pixel in Morton order
-    // Framebuffer images are split into 128x128 tiles.
-
-    const unsigned int block_height = 128;
-    const unsigned int coarse_x = x & ~127;
-
-    u32 i = MortonInterleave128(x, y);
-
-    const unsigned int offset = coarse_x * block_height;
-
-    return (i + offset) * bytes_per_pixel;
-}
-
-static void MortonCopyPixels128(u32 width, u32 height, u32 bytes_per_pixel, u32 gl_bytes_per_pixel,
-                                u8* morton_data, u8* gl_data, bool morton_to_gl) {
-    u8* data_ptrs[2];
-    for (unsigned y = 0; y < height; ++y) {
-        for (unsigned x = 0; x < width; ++x) {
-            const u32 coarse_y = y & ~127;
-            u32 morton_offset =
-                GetMortonOffset128(x, y, bytes_per_pixel) + coarse_y * width * bytes_per_pixel;
-            u32 gl_pixel_index = (x + (height - 1 - y) * width) * gl_bytes_per_pixel;
-
-            data_ptrs[morton_to_gl] = morton_data + morton_offset;
-            data_ptrs[!morton_to_gl] = &gl_data[gl_pixel_index];
-
-            memcpy(data_ptrs[0], data_ptrs[1], bytes_per_pixel);
-        }
-    }
-}
-
 /**
  * Loads framebuffer from emulated memory into the active OpenGL texture.
  */
@@ -249,43 +155,74 @@ void RendererOpenGL::LoadFBToScreenInfo(const FramebufferInfo& framebuffer_info,
                                         ScreenInfo& screen_info) {
     const u32 bpp{FramebufferInfo::BytesPerPixel(framebuffer_info.pixel_format)};
     const u32 size_in_bytes{framebuffer_info.stride * framebuffer_info.height * bpp};
+    const size_t swizzled_size{VideoCore::GetBlockLinearSize(
+        framebuffer_info.width, framebuffer_info.height, bpp, VideoCore::FRAMEBUFFER_BLOCK_HEIGHT)};
+
+    Memory::RasterizerFlushRegion(framebuffer_info.address, size_in_bytes);
 
-    MortonCopyPixels128(framebuffer_info.width, framebuffer_info.height, bpp, 4,
-                        Memory::GetPointer(framebuffer_info.address), gl_framebuffer_data.data(),
-                        true);
+    // Games commonly flip the same buffer several times in a row, e.g. while loading. Skip the
+    // deswizzle and the upload when the texture already holds identical contents.
+    u8* framebuffer_data = Memory::GetPointer(framebuffer_info.address);
+    const u64 hash{Common::ComputeHash64(framebuffer_data, swizzled_size)};
+    auto& perf_stats = Core::System::GetInstance().perf_stats;
+    if (screen_info.texture.contents_hash && *screen_info.texture.contents_hash == hash) {
+        perf_stats.AddFramebufferLoad(false);
+        return;
+    }
+    perf_stats.AddFramebufferLoad(true);
 
     LOG_TRACE(Render_OpenGL, "0x%08x bytes from 0x%llx(%dx%d), fmt %x", size_in_bytes,
               framebuffer_info.address, framebuffer_info.width, framebuffer_info.height,
               (int)framebuffer_info.pixel_format);
 
-    // Ensure no bad interactions with GL_UNPACK_ALIGNMENT, which by default
-    // only allows rows to have a memory alignement of 4.
-    ASSERT(framebuffer_info.stride % 4 == 0);
+    // The buffer was last uploaded from NUM_UPLOAD_BUFFERS frames ago, so this rarely has to wait
+    UploadBuffer& upload_buffer = upload_buffers[next_upload_buffer];
+    next_upload_buffer = (next_upload_buffer + 1) % NUM_UPLOAD_BUFFERS;
+    if (upload_buffer.fence.handle != nullptr) {
+        glClientWaitSync(upload_buffer.fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT,
+                         GL_TIMEOUT_IGNORED);
+        upload_buffer.fence.Release();
+    }
 
     // Reset the screen info's display texture to its own permanent texture
     screen_info.display_texture = screen_info.texture.resource.handle;
     screen_info.display_texcoords = MathUtil::Rectangle<float>(0.f, 0.f, 1.f, 1.f);
 
-    Memory::RasterizerFlushRegion(framebuffer_info.address, size_in_bytes);
-
     state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
+    state.draw.pixel_unpack_buffer = upload_buffer.buffer.handle;
     state.Apply();
 
-    glActiveTexture(GL_TEXTURE0);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)framebuffer_info.stride);
-
-    // Update existing texture
-    // TODO: Test what happens on hardware when you change the framebuffer dimensions so that
-    //       they differ from the LCD resolution.
-    // TODO: Applications could theoretically crash Citra here by specifying too large
-    //       framebuffer sizes. We should make sure that this cannot happen.
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer_info.width, framebuffer_info.height,
-                    screen_info.texture.gl_format, screen_info.texture.gl_type,
-                    gl_framebuffer_data.data());
-
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    // Deswizzle straight into the buffer. The fence above already guarantees that the GPU is done
+    // with it, so the mapping doesn't need to be synchronized by the driver.
+    constexpr GLbitfield map_flags =
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    auto* upload_data = static_cast<u8*>(
+        glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, upload_buffer_size, map_flags));
+    if (upload_data == nullptr) {
+        LOG_ERROR(Render_OpenGL, "Failed to map the framebuffer upload buffer");
+    } else {
+        VideoCore::CopySwizzledData(framebuffer_info.width, framebuffer_info.height, bpp,
+                                    VideoCore::FRAMEBUFFER_BLOCK_HEIGHT, framebuffer_data,
+                                    upload_data, true, true);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // Update existing texture, the copy from the buffer happens asynchronously on the GPU.
+        // The deswizzled rows are tightly packed, so GL_UNPACK_ROW_LENGTH stays at 0.
+        // TODO: Test what happens on hardware when you change the framebuffer dimensions so that
+        //       they differ from the LCD resolution.
+        // TODO: Applications could theoretically crash Citra here by specifying too large
+        //       framebuffer sizes. We should make sure that this cannot happen.
+        glActiveTexture(GL_TEXTURE0);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer_info.width, framebuffer_info.height,
+                        screen_info.texture.gl_format, screen_info.texture.gl_type, nullptr);
+        upload_buffer.fence.Create();
+
+        // Only now does the texture hold these contents, a failed upload must be retried
+        screen_info.texture.contents_hash = hash;
+    }
 
     state.texture_units[0].texture_2d = 0;
+    state.draw.pixel_unpack_buffer = 0;
     state.Apply();
 }
 
@@ -320,7 +257,8 @@ void RendererOpenGL::InitOpenGLObjects() {
     state.draw.shader_program = shader.handle;
     state.Apply();
     uniform_modelview_matrix = glGetUniformLocation(shader.handle, "modelview_matrix");
-    uniform_color_texture = glGetUniformLocation(shader.handle, "color_texture");
+    uniform_layer_textures = glGetUniformLocation(shader.handle, "layer_textures");
+    uniform_num_layers = glGetUniformLocation(shader.handle, "num_layers");
     attrib_position = glGetAttribLocation(shader.handle, "vert_position");
     attrib_tex_coord = glGetAttribLocation(shader.handle, "vert_tex_coord");
 
@@ -344,29 +282,32 @@ void RendererOpenGL::InitOpenGLObjects() {
     glEnableVertexAttribArray(attrib_position);
     glEnableVertexAttribArray(attrib_tex_coord);
 
-    // Allocate textures for the screen
-    screen_info.texture.resource.Create();
+    // Allocate textures for the layers
+    for (auto& screen_info : layers) {
+        screen_info.texture.resource.Create();
 
-    // Allocation of storage is deferred until the first frame, when we
-    // know the framebuffer size.
+        // Allocation of storage is deferred until the first frame, when we
+        // know the framebuffer size.
 
-    state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
-    state.Apply();
+        state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
+        state.Apply();
 
-    glActiveTexture(GL_TEXTURE0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glActiveTexture(GL_TEXTURE0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    screen_info.display_texture = screen_info.texture.resource.handle;
+        screen_info.display_texture = screen_info.texture.resource.handle;
+        screen_info.display_texcoords = MathUtil::Rectangle<float>(0.f, 0.f, 1.f, 1.f);
 
-    state.texture_units[0].texture_2d = 0;
-    state.Apply();
+        state.texture_units[0].texture_2d = 0;
+        state.Apply();
 
-    // Clear screen to black
-    LoadColorToActiveGLTexture(0, 0, 0, 0, screen_info.texture);
+        // Clear to transparent black, so that layers without contents don't hide the ones below
+        LoadColorToActiveGLTexture(0, 0, 0, 0, screen_info.texture);
+    }
 }
 
 void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
@@ -374,6 +315,8 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
 
     texture.width = framebuffer_info.width;
     texture.height = framebuffer_info.height;
+    texture.pixel_format = framebuffer_info.pixel_format;
+    texture.contents_hash = boost::none;
 
     GLint internal_format;
     switch (framebuffer_info.pixel_format) {
@@ -382,7 +325,7 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
         internal_format = GL_RGBA;
         texture.gl_format = GL_RGBA;
         texture.gl_type = GL_UNSIGNED_INT_8_8_8_8;
-        gl_framebuffer_data.resize(texture.width * texture.height * 4);
+        ConfigureUploadBuffers(texture.width * texture.height * 4);
         break;
     default:
         UNIMPLEMENTED();
@@ -399,9 +342,40 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
     state.Apply();
 }
 
-void RendererOpenGL::DrawSingleScreen(const ScreenInfo& screen_info, float x, float y, float w,
-                                      float h) {
-    auto& texcoords = screen_info.display_texcoords;
+/**
+ * (Re)allocates the framebuffer upload buffers, waiting for any pending upload from them.
+ */
+void RendererOpenGL::ConfigureUploadBuffers(size_t size) {
+    // The buffers are shared by all layers, only ever grow them so that layers of different sizes
+    // don't keep reallocating them
+    if (size <= upload_buffer_size) {
+        return;
+    }
+    upload_buffer_size = size;
+
+    for (auto& upload_buffer : upload_buffers) {
+        if (upload_buffer.fence.handle != nullptr) {
+            glClientWaitSync(upload_buffer.fence.handle, GL_SYNC_FLUSH_COMMANDS_BIT,
+                             GL_TIMEOUT_IGNORED);
+            upload_buffer.fence.Release();
+        }
+        upload_buffer.buffer.Create();
+
+        state.draw.pixel_unpack_buffer = upload_buffer.buffer.handle;
+        state.Apply();
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, upload_buffer_size, nullptr, GL_STREAM_DRAW);
+    }
+
+    state.draw.pixel_unpack_buffer = 0;
+    state.Apply();
+}
+
+/**
+ * Draws the layers to a rectangle of the window, blending all of them in a single pass.
+ */
+void RendererOpenGL::DrawLayers(size_t num_layers, float x, float y, float w, float h) {
+    // Every layer is stretched over the whole screen
+    auto& texcoords = layers[0].display_texcoords;
 
     std::array<ScreenRectVertex, 4> vertices = {{
         ScreenRectVertex(x, y, texcoords.top, texcoords.right),
@@ -410,20 +384,25 @@ void RendererOpenGL::DrawSingleScreen(const ScreenInfo& screen_info, float x, fl
         ScreenRectVertex(x + w, y + h, texcoords.bottom, texcoords.left),
     }};
 
-    state.texture_units[0].texture_2d = screen_info.display_texture;
+    for (size_t i = 0; i < num_layers; ++i) {
+        state.texture_units[i].texture_2d = layers[i].display_texture;
+    }
     state.Apply();
 
+    glUniform1i(uniform_num_layers, static_cast<GLint>(num_layers));
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices.data());
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-    state.texture_units[0].texture_2d = 0;
+    for (size_t i = 0; i < num_layers; ++i) {
+        state.texture_units[i].texture_2d = 0;
+    }
     state.Apply();
 }
 
 /**
  * Draws the emulated screens to the emulator window.
  */
-void RendererOpenGL::DrawScreens() {
+void RendererOpenGL::DrawScreens(size_t num_layers) {
     const auto& layout = render_window->GetFramebufferLayout();
     const auto& screen = layout.screen;
 
@@ -435,14 +414,23 @@ void RendererOpenGL::DrawScreens() {
         MakeOrthographicMatrix((float)layout.width, (float)layout.height);
     glUniformMatrix3x2fv(uniform_modelview_matrix, 1, GL_FALSE, ortho_matrix.data());
 
-    // Bind texture in Texture Unit 0
-    glActiveTexture(GL_TEXTURE0);
-    glUniform1i(uniform_color_texture, 0);
+    // Layer i is sampled from texture unit i
+    std::array<GLint, MAX_LAYERS> texture_units;
+    for (size_t i = 0; i < MAX_LAYERS; ++i) {
+        texture_units[i] = static_cast<GLint>(i);
+    }
+    glUniform1iv(uniform_layer_textures, MAX_LAYERS, texture_units.data());
+
+    DrawLayers(num_layers, (float)screen.left, (float)screen.top, (float)screen.GetWidth(),
+               (float)screen.GetHeight());
 
-    DrawSingleScreen(screen_info, (float)screen.left, (float)screen.top, (float)screen.GetWidth(),
-                     (float)screen.GetHeight());
+    presented_width = layout.width;
+    presented_height = layout.height;
+}
 
-    m_current_frame++;
+bool RendererOpenGL::NeedsRepaint() const {
+    const auto& layout = render_window->GetFramebufferLayout();
+    return layout.width != presented_width || layout.height != presented_height;
 }
 
 /// Updates the framerate
@@ -4,7 +4,8 @@
 
 #pragma once
 
-#include <vector>
+#include <array>
+#include <boost/optional.hpp>
 #include <glad/glad.h>
 #include "common/common_types.h"
 #include "common/math_util.h"
@@ -22,6 +23,8 @@ struct TextureInfo {
     GLenum gl_format;
     GLenum gl_type;
     RendererBase::FramebufferInfo::PixelFormat pixel_format;
+    /// Hash of the guest framebuffer last uploaded to the texture, if any
+    boost::optional<u64> contents_hash;
 };
 
 /// Structure used for storing information about the display target for each 3DS screen
@@ -36,8 +39,8 @@ public:
     RendererOpenGL();
     ~RendererOpenGL() override;
 
-    /// Swap buffers (render frame)
-    void SwapBuffers(boost::optional<const FramebufferInfo&> framebuffer_info) override;
+    void LoadFramebuffer(size_t layer, const FramebufferInfo& framebuffer_info) override;
+    void Present(size_t num_layers) override;
 
     /**
      * Set the emulator window to use for renderer
@@ -51,11 +54,16 @@ public:
     /// Shutdown the renderer
     void ShutDown() override;
 
+protected:
+    /// Repaints the window when it was resized since the last present
+    bool NeedsRepaint() const override;
+
 private:
     void InitOpenGLObjects();
     void ConfigureFramebufferTexture(TextureInfo& texture, const FramebufferInfo& framebuffer_info);
-    void DrawScreens();
-    void DrawSingleScreen(const ScreenInfo& screen_info, float x, float y, float w, float h);
+    void ConfigureUploadBuffers(size_t size);
+    void DrawScreens(size_t num_layers);
+    void DrawLayers(size_t num_layers, float x, float y, float w, float h);
     void UpdateFramerate();
 
     // Loads framebuffer from emulated memory into the display information structure
@@ -66,6 +74,10 @@ private:
 
     EmuWindow* render_window; ///< Handle to render window
 
+    /// Size of the window framebuffer when it was last drawn to
+    unsigned presented_width = 0;
+    unsigned presented_height = 0;
+
     OpenGLState state;
 
     // OpenGL object IDs
@@ -73,15 +85,30 @@ private:
     OGLBuffer vertex_buffer;
     OGLShader shader;
 
-    /// Display information for Switch screen
-    ScreenInfo screen_info;
+    /// Display information for each layer of the Switch screen
+    std::array<ScreenInfo, MAX_LAYERS> layers;
+
+    /// Pixel unpack buffer which framebuffers are deswizzled into and uploaded from
+    struct UploadBuffer {
+        OGLBuffer buffer;
+        /// Signalled once the GPU is done uploading the buffer's contents to the texture
+        OGLSync fence;
+    };
+
+    /// Number of upload buffers, enough for the GPU to still be reading from two of them
+    static constexpr size_t NUM_UPLOAD_BUFFERS = 3;
 
-    /// OpenGL framebuffer data
-    std::vector<u8> gl_framebuffer_data;
+    /// Ring of buffers used to stream framebuffers to the screen texture
+    std::array<UploadBuffer, NUM_UPLOAD_BUFFERS> upload_buffers;
+    /// Index of the upload buffer to use for the next framebuffer
+    size_t next_upload_buffer = 0;
+    /// Size of each upload buffer, in bytes
+    size_t upload_buffer_size = 0;
 
     // Shader uniform location indices
     GLuint uniform_modelview_matrix;
-    GLuint uniform_color_texture;
+    GLuint uniform_layer_textures;
+    GLuint uniform_num_layers;
 
     // Shader attribute input indices
     GLuint attrib_position;
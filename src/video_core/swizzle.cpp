@@ -0,0 +1,220 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "common/assert.h"
+#include "video_core/swizzle.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace VideoCore {
+
+namespace {
+
+/// Size of the smallest contiguous run of bytes inside a GOB
+constexpr u32 SECTOR_SIZE = 16;
+
+/// Offsets of the four sectors of a GOB line, relative to the first sector of the line
+constexpr std::array<u32, 4> SECTOR_OFFSETS{{0, 32, 256, 288}};
+
+/// Offset of a line inside its GOB
+constexpr u32 GetGobLineOffset(u32 gob_y) {
+    return (gob_y / 2) * 64 + (gob_y % 2) * SECTOR_SIZE;
+}
+
+template <bool unswizzle>
+void CopyBytes(u8* swizzled, u8* linear, size_t size) {
+    if (unswizzle) {
+        std::memcpy(linear, swizzled, size);
+    } else {
+        std::memcpy(swizzled, linear, size);
+    }
+}
+
+/**
+ * Copies a single line starting at the given byte offset, sector by sector. Handles images whose
+ * width is not a multiple of a GOB.
+ */
+template <bool unswizzle>
+void CopyLineGeneric(u8* swizzled_line, u8* linear_line, u32 start, u32 line_size,
+                     u32 block_size) {
+    for (u32 x = start; x < line_size; x += SECTOR_SIZE) {
+        const u32 gob_x = x % GOB_SIZE_X;
+        u8* sector = swizzled_line + (x / GOB_SIZE_X) * block_size +
+                     SECTOR_OFFSETS[gob_x / SECTOR_SIZE];
+        CopyBytes<unswizzle>(sector, linear_line + x, std::min(SECTOR_SIZE, line_size - x));
+    }
+}
+
+/**
+ * Copies the full GOBs of an even line and the line below it. The two lines of a pair share
+ * their sectors' 32 byte slots, which is what the AVX2 path takes advantage of.
+ */
+using CopyLinePairFunc = void (*)(u8* swizzled_line, u8* linear_line0, u8* linear_line1,
+                                  u32 num_gobs, u32 block_size);
+
+template <bool unswizzle>
+void CopyLinePairGeneric(u8* swizzled_line, u8* linear_line0, u8* linear_line1, u32 num_gobs,
+                         u32 block_size) {
+    for (u32 gob = 0; gob < num_gobs; ++gob) {
+        u8* swizzled_gob = swizzled_line + gob * block_size;
+        for (u32 sector = 0; sector < SECTOR_OFFSETS.size(); ++sector) {
+            u8* swizzled_sector = swizzled_gob + SECTOR_OFFSETS[sector];
+            const u32 linear_x = gob * GOB_SIZE_X + sector * SECTOR_SIZE;
+            CopyBytes<unswizzle>(swizzled_sector, linear_line0 + linear_x, SECTOR_SIZE);
+            CopyBytes<unswizzle>(swizzled_sector + SECTOR_SIZE, linear_line1 + linear_x,
+                                 SECTOR_SIZE);
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+template <bool unswizzle>
+void CopyLinePairSSE2(u8* swizzled_line, u8* linear_line0, u8* linear_line1, u32 num_gobs,
+                      u32 block_size) {
+    for (u32 gob = 0; gob < num_gobs; ++gob) {
+        u8* swizzled_gob = swizzled_line + gob * block_size;
+        __m128i* linear0 = reinterpret_cast<__m128i*>(linear_line0 + gob * GOB_SIZE_X);
+        __m128i* linear1 = reinterpret_cast<__m128i*>(linear_line1 + gob * GOB_SIZE_X);
+        for (u32 sector = 0; sector < SECTOR_OFFSETS.size(); ++sector) {
+            __m128i* swizzled0 = reinterpret_cast<__m128i*>(swizzled_gob + SECTOR_OFFSETS[sector]);
+            __m128i* swizzled1 = swizzled0 + 1;
+            if (unswizzle) {
+                _mm_storeu_si128(linear0 + sector, _mm_loadu_si128(swizzled0));
+                _mm_storeu_si128(linear1 + sector, _mm_loadu_si128(swizzled1));
+            } else {
+                _mm_storeu_si128(swizzled0, _mm_loadu_si128(linear0 + sector));
+                _mm_storeu_si128(swizzled1, _mm_loadu_si128(linear1 + sector));
+            }
+        }
+    }
+}
+
+template <bool unswizzle>
+TARGET_AVX2 void CopyLinePairAVX2(u8* swizzled_line, u8* linear_line0, u8* linear_line1,
+                                  u32 num_gobs, u32 block_size) {
+    for (u32 gob = 0; gob < num_gobs; ++gob) {
+        u8* swizzled_gob = swizzled_line + gob * block_size;
+        __m128i* linear0 = reinterpret_cast<__m128i*>(linear_line0 + gob * GOB_SIZE_X);
+        __m128i* linear1 = reinterpret_cast<__m128i*>(linear_line1 + gob * GOB_SIZE_X);
+        for (u32 sector = 0; sector < SECTOR_OFFSETS.size(); ++sector) {
+            __m256i* swizzled = reinterpret_cast<__m256i*>(swizzled_gob + SECTOR_OFFSETS[sector]);
+            if (unswizzle) {
+                const __m256i pair = _mm256_loadu_si256(swizzled);
+                _mm_storeu_si128(linear0 + sector, _mm256_castsi256_si128(pair));
+                _mm_storeu_si128(linear1 + sector, _mm256_extracti128_si256(pair, 1));
+            } else {
+                const __m128i line0 = _mm_loadu_si128(linear0 + sector);
+                const __m128i line1 = _mm_loadu_si128(linear1 + sector);
+                const __m256i pair =
+                    _mm256_inserti128_si256(_mm256_castsi128_si256(line0), line1, 1);
+                _mm256_storeu_si256(swizzled, pair);
+            }
+        }
+    }
+}
+
+#endif
+
+/// Selects the widest line pair copy routine supported by the host
+template <bool unswizzle>
+CopyLinePairFunc SelectCopyLinePair() {
+#ifdef ARCHITECTURE_x86_64
+    if (Common::GetCPUCaps().avx2) {
+        return CopyLinePairAVX2<unswizzle>;
+    }
+    return CopyLinePairSSE2<unswizzle>;
+#else
+    return CopyLinePairGeneric<unswizzle>;
+#endif
+}
+
+template <bool unswizzle>
+void CopySwizzledDataImpl(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height,
+                          u8* swizzled_data, u8* linear_data, bool flip_y) {
+    static const CopyLinePairFunc copy_line_pair = SelectCopyLinePair<unswizzle>();
+
+    const u32 line_size = width * bytes_per_pixel;
+    const u32 image_width_in_gobs = (line_size + GOB_SIZE_X - 1) / GOB_SIZE_X;
+    const u32 full_gobs = line_size / GOB_SIZE_X;
+    const u32 block_size = GOB_SIZE * block_height;
+    const u32 lines_per_block = GOB_SIZE_Y * block_height;
+
+    const auto get_linear_line = [&](u32 y) {
+        return linear_data + (flip_y ? height - 1 - y : y) * line_size;
+    };
+
+    for (u32 y = 0; y < height; y += 2) {
+        const u32 block_row = y / lines_per_block;
+        const u32 gob_in_block = (y / GOB_SIZE_Y) % block_height;
+        u8* swizzled_line = swizzled_data + block_row * image_width_in_gobs * block_size +
+                            gob_in_block * GOB_SIZE + GetGobLineOffset(y % GOB_SIZE_Y);
+
+        u8* linear_line0 = get_linear_line(y);
+        if (y + 1 == height) {
+            // Odd number of lines, the last one has no pair
+            CopyLineGeneric<unswizzle>(swizzled_line, linear_line0, 0, line_size, block_size);
+            break;
+        }
+
+        u8* linear_line1 = get_linear_line(y + 1);
+        copy_line_pair(swizzled_line, linear_line0, linear_line1, full_gobs, block_size);
+
+        if (full_gobs != image_width_in_gobs) {
+            const u32 tail_start = full_gobs * GOB_SIZE_X;
+            CopyLineGeneric<unswizzle>(swizzled_line, linear_line0, tail_start, line_size,
+                                       block_size);
+            CopyLineGeneric<unswizzle>(swizzled_line + SECTOR_SIZE, linear_line1, tail_start,
+                                       line_size, block_size);
+        }
+    }
+}
+
+} // Anonymous namespace
+
+void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height,
+                      u8* swizzled_data, u8* linear_data, bool unswizzle, bool flip_y) {
+    ASSERT(block_height != 0);
+
+    if (unswizzle) {
+        CopySwizzledDataImpl<true>(width, height, bytes_per_pixel, block_height, swizzled_data,
+                                   linear_data, flip_y);
+    } else {
+        CopySwizzledDataImpl<false>(width, height, bytes_per_pixel, block_height, swizzled_data,
+                                    linear_data, flip_y);
+    }
+}
+
+void CopySwizzledDataPerPixel(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height,
+                              u8* swizzled_data, u8* linear_data, bool unswizzle, bool flip_y) {
+    const u32 image_width_in_gobs = (width * bytes_per_pixel + GOB_SIZE_X - 1) / GOB_SIZE_X;
+    u8* data_ptrs[2];
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const u32 swizzled_offset =
+                GetBlockLinearOffset(x * bytes_per_pixel, y, image_width_in_gobs, block_height);
+            const u32 linear_y = flip_y ? height - 1 - y : y;
+            const u32 linear_offset = (x + linear_y * width) * bytes_per_pixel;
+
+            data_ptrs[unswizzle] = swizzled_data + swizzled_offset;
+            data_ptrs[!unswizzle] = linear_data + linear_offset;
+
+            std::memcpy(data_ptrs[0], data_ptrs[1], bytes_per_pixel);
+        }
+    }
+}
+
+} // namespace VideoCore
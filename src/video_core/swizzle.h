@@ -0,0 +1,83 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/**
+ * Block-linear surfaces are made of GOBs (groups of bytes): 64 byte wide, 8 line tall tiles that
+ * are stacked vertically into blocks of `block_height` GOBs. Blocks are then laid out left to
+ * right, one row of blocks after another. Inside a GOB, each line is split into four 16 byte
+ * sectors which are interleaved with the sectors of the neighbouring lines.
+ */
+constexpr u32 GOB_SIZE_X = 64;
+constexpr u32 GOB_SIZE_Y = 8;
+constexpr u32 GOB_SIZE = GOB_SIZE_X * GOB_SIZE_Y;
+
+/// Default block height, in GOBs, of the framebuffers handed to nvdisp
+constexpr u32 FRAMEBUFFER_BLOCK_HEIGHT = 16;
+
+/**
+ * Copies an image between its block-linear and linear representations, a whole GOB line at a
+ * time. Uses the widest SIMD path supported by the host CPU.
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param bytes_per_pixel Size of a pixel in bytes
+ * @param block_height Height of a block in GOBs
+ * @param swizzled_data Pointer to the block-linear image
+ * @param linear_data Pointer to the linear image, with rows of width * bytes_per_pixel bytes
+ * @param unswizzle If true, copies from swizzled_data to linear_data, otherwise the other way
+ * @param flip_y If true, the first linear row corresponds to the last block-linear line
+ */
+void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height,
+                      u8* swizzled_data, u8* linear_data, bool unswizzle, bool flip_y);
+
+/**
+ * Reference implementation of CopySwizzledData, which computes the address of every pixel on its
+ * own. Used to validate and benchmark the optimized paths.
+ */
+void CopySwizzledDataPerPixel(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height,
+                              u8* swizzled_data, u8* linear_data, bool unswizzle, bool flip_y);
+
+/**
+ * Returns the size in bytes of a block-linear image, including the padding up to whole blocks
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param bytes_per_pixel Size of a pixel in bytes
+ * @param block_height Height of a block in GOBs
+ */
+inline size_t GetBlockLinearSize(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height) {
+    const u32 image_width_in_gobs = (width * bytes_per_pixel + GOB_SIZE_X - 1) / GOB_SIZE_X;
+    const u32 lines_per_block = GOB_SIZE_Y * block_height;
+    const u32 block_rows = (height + lines_per_block - 1) / lines_per_block;
+    return static_cast<size_t>(block_rows) * image_width_in_gobs * GOB_SIZE * block_height;
+}
+
+/**
+ * Returns the byte offset of a pixel inside a block-linear image
+ * @param x Horizontal position of the pixel, in bytes
+ * @param y Vertical position of the pixel, in lines
+ * @param image_width_in_gobs Width of the image in GOBs, rounded up
+ * @param block_height Height of a block in GOBs
+ */
+inline u32 GetBlockLinearOffset(u32 x, u32 y, u32 image_width_in_gobs, u32 block_height) {
+    const u32 block_size = GOB_SIZE * block_height;
+    const u32 block_row = y / (GOB_SIZE_Y * block_height);
+    const u32 gob_in_block = (y / GOB_SIZE_Y) % block_height;
+
+    const u32 gob_address =
+        block_row * image_width_in_gobs * block_size + (x / GOB_SIZE_X) * block_size +
+        gob_in_block * GOB_SIZE;
+
+    const u32 gob_x = x % GOB_SIZE_X;
+    const u32 gob_y = y % GOB_SIZE_Y;
+    return gob_address + (gob_x / 32) * 256 + (gob_y / 2) * 64 + ((gob_x % 32) / 16) * 32 +
+           (gob_y % 2) * 16 + (gob_x % 16);
+}
+
+} // namespace VideoCore
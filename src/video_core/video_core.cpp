@@ -4,7 +4,12 @@
 
 #include <memory>
 #include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_null/renderer_null.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
 
@@ -16,12 +21,22 @@ namespace VideoCore {
 EmuWindow* g_emu_window = nullptr;        ///< Frontend emulator window
 std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
+/// Presentation thread, only used with asynchronous GPU emulation
+static std::unique_ptr<GPUThread> gpu_thread;
+
 std::atomic<bool> g_toggle_framelimit_enabled;
 
 /// Initialize the video core
 bool Init(EmuWindow* emu_window) {
     g_emu_window = emu_window;
-    g_renderer = std::make_unique<RendererOpenGL>();
+    switch (Settings::values.renderer_backend) {
+    case Settings::RendererBackend::Null:
+        g_renderer = std::make_unique<RendererNull>();
+        break;
+    default:
+        g_renderer = std::make_unique<RendererOpenGL>();
+        break;
+    }
     g_renderer->SetWindow(g_emu_window);
     if (g_renderer->Init()) {
         LOG_DEBUG(Render, "initialized OK");
@@ -29,14 +44,36 @@ bool Init(EmuWindow* emu_window) {
         LOG_ERROR(Render, "initialization failed !");
         return false;
     }
+
+    if (Settings::values.use_asynchronous_gpu_emulation) {
+        gpu_thread = std::make_unique<GPUThread>(*g_renderer, *g_emu_window);
+    }
     return true;
 }
 
 /// Shutdown the video core
 void Shutdown() {
+    gpu_thread.reset();
     g_renderer.reset();
 
     LOG_DEBUG(Render, "shutdown OK");
 }
 
+u64 SwapBuffers(const RendererBase::Composition& composition) {
+    // Window events are always handled on the emulation thread, which is the one that owns the
+    // window in the SDL frontend
+    g_emu_window->PollEvents();
+
+    if (gpu_thread) {
+        return gpu_thread->SwapBuffers(composition, CoreTiming::GetGlobalTimeUs());
+    }
+
+    g_renderer->SwapBuffers(composition, CoreTiming::GetGlobalTimeUs());
+    return 0;
+}
+
+bool IsFenceSignalled(u64 fence) {
+    return !gpu_thread || gpu_thread->IsFenceSignalled(fence);
+}
+
 } // namespace
@@ -6,9 +6,10 @@
 
 #include <atomic>
 #include <memory>
+#include "common/common_types.h"
+#include "video_core/renderer_base.h"
 
 class EmuWindow;
-class RendererBase;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Video Core namespace
@@ -31,4 +32,14 @@ bool Init(EmuWindow* emu_window);
 /// Shutdown the video core
 void Shutdown();
 
+/**
+ * Presents a frame, on the GPU thread when asynchronous GPU emulation is enabled.
+ * @param composition Layers to display, without any framebuffer to present the previous frame again
+ * @return Fence that is signalled once the framebuffers have been read from emulated memory
+ */
+u64 SwapBuffers(const RendererBase::Composition& composition);
+
+/// Returns whether the framebuffers of the given fence have been read from emulated memory
+bool IsFenceSignalled(u64 fence);
+
 } // namespace
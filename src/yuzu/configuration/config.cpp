@@ -71,11 +71,17 @@ void Config::ReadValues() {
     qt_config->beginGroup("Core");
     Settings::values.cpu_core =
         static_cast<Settings::CpuCore>(qt_config->value("cpu_core", 0).toInt());
+    Settings::values.use_multi_core = qt_config->value("use_multi_core", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
+    Settings::values.renderer_backend =
+        static_cast<Settings::RendererBackend>(qt_config->value("renderer_backend", 0).toInt());
     Settings::values.resolution_factor = qt_config->value("resolution_factor", 1.0).toFloat();
     Settings::values.toggle_framelimit = qt_config->value("toggle_framelimit", true).toBool();
+    Settings::values.frame_limit = qt_config->value("frame_limit", 100).toInt();
+    Settings::values.use_asynchronous_gpu_emulation =
+        qt_config->value("use_asynchronous_gpu_emulation", false).toBool();
 
     Settings::values.bg_red = qt_config->value("bg_red", 0.0).toFloat();
     Settings::values.bg_green = qt_config->value("bg_green", 0.0).toFloat();
@@ -164,11 +170,16 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     qt_config->setValue("cpu_core", static_cast<int>(Settings::values.cpu_core));
+    qt_config->setValue("use_multi_core", Settings::values.use_multi_core);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
+    qt_config->setValue("renderer_backend", static_cast<int>(Settings::values.renderer_backend));
     qt_config->setValue("resolution_factor", (double)Settings::values.resolution_factor);
     qt_config->setValue("toggle_framelimit", Settings::values.toggle_framelimit);
+    qt_config->setValue("frame_limit", Settings::values.frame_limit);
+    qt_config->setValue("use_asynchronous_gpu_emulation",
+                        Settings::values.use_asynchronous_gpu_emulation);
 
     // Cast to double because Qt's written float values are not human-readable
     qt_config->setValue("bg_red", (double)Settings::values.bg_red);
@@ -80,7 +80,15 @@ touch_device=
 # 0 (default): Unicorn (slow), 1: Dynarmic (faster)
 cpu_core =
 
+# Whether to run each of the four emulated CPU cores on its own host thread
+# 0 (default): Off, 1: On
+use_multi_core =
+
 [Renderer]
+# Which renderer to use to display the emulated screen
+# 0 (default): OpenGL, 1: Null (displays nothing, for running without a GPU)
+renderer_backend =
+
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
 use_hw_renderer =
@@ -128,6 +136,15 @@ custom_bottom_bottom =
 # 0: Off , 1  (default): On
 toggle_framelimit =
 
+# Emulation speed targeted by the frame limiter, in percent of the console's speed. Values above 100
+# fast-forward the game.
+# 1 - 9999: Speed limit in percent, 100 (default)
+frame_limit =
+
+# Whether to present frames on a separate thread, overlapping presentation with CPU emulation
+# 0 (default): Off, 1: On
+use_asynchronous_gpu_emulation =
+
 # Swaps the prominent screen with the other screen.
 # For example, if Single Screen is chosen, setting this to 1 will display the bottom screen instead of the top screen.
 # 0 (default): Top Screen is prominent, 1: Bottom Screen is prominent
@@ -0,0 +1,26 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/frontend/framebuffer_layout.h"
+#include "input_common/main.h"
+#include "yuzu_cmd/emu_window/emu_window_headless.h"
+
+EmuWindow_Headless::EmuWindow_Headless() {
+    // Input devices are still created from the configuration, they just never get any event
+    InputCommon::Init();
+
+    UpdateCurrentFramebufferLayout(Layout::ScreenUndocked::Width, Layout::ScreenUndocked::Height);
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() {
+    InputCommon::Shutdown();
+}
+
+void EmuWindow_Headless::SwapBuffers() {}
+
+void EmuWindow_Headless::PollEvents() {}
+
+void EmuWindow_Headless::MakeCurrent() {}
+
+void EmuWindow_Headless::DoneCurrent() {}
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -31,30 +33,86 @@
 #include "common/scope_exit.h"
 #include "common/string_util.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/loader/loader.h"
 #include "core/settings.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/video_core.h"
 #include "yuzu_cmd/config.h"
+#include "yuzu_cmd/emu_window/emu_window_headless.h"
 #include "yuzu_cmd/emu_window/emu_window_sdl2.h"
 
 static void PrintHelp(const char* argv0) {
     std::cout << "Usage: " << argv0
               << " [options] <filename>\n"
-                 "-g, --gdbport=NUMBER  Enable gdb stub on port NUMBER\n"
-                 "-h, --help            Display this help and exit\n"
-                 "-v, --version         Output version information and exit\n";
+                 "-b, --benchmark=FRAMES  Run FRAMES frames without frame limiting, then print\n"
+                 "                        performance statistics and exit\n"
+                 "-g, --gdbport=NUMBER    Enable gdb stub on port NUMBER\n"
+                 "-h, --help              Display this help and exit\n"
+                 "-r, --renderer=NAME     Renderer to use: opengl, or null to display nothing\n"
+                 "-v, --version           Output version information and exit\n";
 }
 
 static void PrintVersion() {
     std::cout << "yuzu " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
 }
 
+/// Runs the loaded application for a fixed number of guest frames and reports its performance
+static int RunBenchmark(Core::System& system, int num_frames) {
+    using Clock = std::chrono::steady_clock;
+
+    const int first_frame = VideoCore::g_renderer->GetCurrentFrame();
+    const u64 start_time_us = CoreTiming::GetGlobalTimeUs();
+    const auto start = Clock::now();
+    system.GetAndResetPerfStats();
+
+    while (VideoCore::g_renderer->GetCurrentFrame() - first_frame < num_frames) {
+        if (system.RunLoop() != Core::System::ResultStatus::Success) {
+            LOG_CRITICAL(Frontend, "Emulation stopped before the end of the benchmark");
+            return -1;
+        }
+    }
+
+    const auto results = system.GetAndResetPerfStats();
+    const double wall_time = std::chrono::duration<double>(Clock::now() - start).count();
+    const double emulated_time = (CoreTiming::GetGlobalTimeUs() - start_time_us) / 1000000.0;
+
+    std::printf("Frames:            %d\n", num_frames);
+    std::printf("Wall time:         %.3f s\n", wall_time);
+    std::printf("Emulated time:     %.3f s (%.1f%% speed)\n", emulated_time,
+                results.emulation_speed * 100.0);
+    std::printf("Guest FPS:         %.2f\n", results.game_fps);
+    std::printf("Frametime:         %.3f ms\n", results.frametime * 1000.0);
+
+    static constexpr const char* subsystem_names[Core::PerfStats::NUM_SUBSYSTEMS]{
+        "CPU", "Services", "Video"};
+    for (size_t i = 0; i < Core::PerfStats::NUM_SUBSYSTEMS; ++i) {
+        std::printf("%-8s time:     %.3f s (%.1f%%)\n", subsystem_names[i],
+                    results.subsystem_time[i], results.subsystem_time[i] * 100.0 / wall_time);
+    }
+
+    std::printf("Idle skips:        %u (%.3f s of emulated time)\n", results.idle_skips,
+                results.idle_skipped_time);
+    std::printf("Framebuffers:      %u uploaded, %u unchanged\n", results.framebuffer_uploads,
+                results.framebuffer_upload_skips);
+    std::printf("Present skips:     %u\n", results.present_skips);
+
+    if (const auto* renderer = dynamic_cast<const RendererNull*>(VideoCore::g_renderer.get())) {
+        std::printf("Output hash:       %016llx\n",
+                    static_cast<unsigned long long>(renderer->GetOutputHash()));
+    }
+    return 0;
+}
+
 /// Application entry point
 int main(int argc, char** argv) {
     Config config;
     int option_index = 0;
     bool use_gdbstub = Settings::values.use_gdbstub;
     u32 gdb_port = static_cast<u32>(Settings::values.gdbstub_port);
+    auto renderer_backend = Settings::values.renderer_backend;
+    int benchmark_frames = 0;
     char* endarg;
 #ifdef _WIN32
     int argc_w;
@@ -68,16 +126,25 @@ int main(int argc, char** argv) {
     std::string filepath;
 
     static struct option long_options[] = {
+        {"benchmark", required_argument, 0, 'b'},
         {"gdbport", required_argument, 0, 'g'},
         {"help", no_argument, 0, 'h'},
+        {"renderer", required_argument, 0, 'r'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:hv", long_options, &option_index);
+        char arg = getopt_long(argc, argv, "b:g:hr:v", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
+            case 'b':
+                benchmark_frames = static_cast<int>(strtol(optarg, &endarg, 0));
+                if (endarg == optarg || benchmark_frames <= 0) {
+                    std::cerr << "--benchmark: Invalid number of frames" << std::endl;
+                    exit(1);
+                }
+                break;
             case 'g':
                 errno = 0;
                 gdb_port = strtoul(optarg, &endarg, 0);
@@ -92,6 +159,16 @@ int main(int argc, char** argv) {
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
+            case 'r':
+                if (std::string(optarg) == "opengl") {
+                    renderer_backend = Settings::RendererBackend::OpenGL;
+                } else if (std::string(optarg) == "null") {
+                    renderer_backend = Settings::RendererBackend::Null;
+                } else {
+                    std::cerr << "--renderer: Unknown renderer " << optarg << std::endl;
+                    exit(1);
+                }
+                break;
             case 'v':
                 PrintVersion();
                 return 0;
@@ -126,15 +203,29 @@ int main(int argc, char** argv) {
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    Settings::values.renderer_backend = renderer_backend;
+    if (benchmark_frames != 0) {
+        Settings::values.toggle_framelimit = false;
+    }
     Settings::Apply();
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>()};
+    // Without a host window there is nothing to close, emulation then only ends with the benchmark
+    std::unique_ptr<EmuWindow_SDL2> sdl_window;
+    std::unique_ptr<EmuWindow_Headless> headless_window;
+    EmuWindow* emu_window;
+    if (renderer_backend == Settings::RendererBackend::Null) {
+        headless_window = std::make_unique<EmuWindow_Headless>();
+        emu_window = headless_window.get();
+    } else {
+        sdl_window = std::make_unique<EmuWindow_SDL2>();
+        emu_window = sdl_window.get();
+    }
 
     Core::System& system{Core::System::GetInstance()};
 
     SCOPE_EXIT({ system.Shutdown(); });
 
-    const Core::System::ResultStatus load_result{system.Load(emu_window.get(), filepath)};
+    const Core::System::ResultStatus load_result{system.Load(emu_window, filepath)};
 
     switch (load_result) {
     case Core::System::ResultStatus::ErrorGetLoader:
@@ -167,7 +258,11 @@ int main(int argc, char** argv) {
 
     Core::Telemetry().AddField(Telemetry::FieldType::App, "Frontend", "SDL");
 
-    while (emu_window->IsOpen()) {
+    if (benchmark_frames != 0) {
+        return RunBenchmark(system, benchmark_frames);
+    }
+
+    while (sdl_window == nullptr || sdl_window->IsOpen()) {
         system.RunLoop();
     }
 